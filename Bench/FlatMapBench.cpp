@@ -0,0 +1,226 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FlatMapBench.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Benchmark for FlatHashMap against std::unordered_map. Reads the
+// entity IDs, relationships and symbols from a TA file written by
+// bfx64 (with -f for symbols) and times inserts, lookups of keys
+// that are present and lookups of keys that aren't on each set.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../Graph/FlatHashMap.h"
+
+using namespace std;
+
+/** Relationship Key (Both Ends and the Relation) */
+struct EdgeKey {
+    string_view src;
+    string_view dst;
+    string_view relation;
+
+    bool operator==(const EdgeKey& other) const {
+        return src == other.src && dst == other.dst && relation == other.relation;
+    }
+};
+struct EdgeKeyHash {
+    size_t operator()(const EdgeKey& key) const {
+        size_t h = StringHash()(key.src);
+        h ^= StringHash()(key.dst) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        return h ^ StringHash()(key.relation);
+    }
+};
+
+/** Best Times Over Every Round (Nanoseconds per Key) */
+struct Result {
+    double insert = 0;
+    double hit = 0;
+    double miss = 0;
+};
+
+/**
+ * Times a function.
+ * @param work The function to run.
+ * @return The elapsed nanoseconds.
+ */
+template <typename Work>
+static double timeNs(Work work){
+    auto start = chrono::steady_clock::now();
+    work();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Fills a map with every key, then looks every key up in shuffled
+ * order along with keys that aren't in it. Keeps the best round.
+ * @param keys The keys, in file order.
+ * @param lookups The same keys, shuffled.
+ * @param misses Keys that aren't in the set.
+ * @param rounds The number of rounds.
+ * @return The best time per key of each operation.
+ */
+template <typename Map, typename Key>
+static Result runMap(const vector<Key>& keys, const vector<Key>& lookups, const vector<Key>& misses, int rounds){
+    Result best;
+    size_t found = 0;
+    for (int round = 0; round < rounds; round++){
+        Map map;
+        double insert = timeNs([&](){
+            for (size_t i = 0; i < keys.size(); i++) map[keys[i]] = (uint32_t) i;
+        });
+        double hit = timeNs([&](){
+            for (const Key& key : lookups) found += map.count(key);
+        });
+        double miss = timeNs([&](){
+            for (const Key& key : misses) found += map.count(key);
+        });
+
+        insert /= (double) keys.size();
+        hit /= (double) lookups.size();
+        miss /= (double) misses.size();
+        if (round == 0 || insert < best.insert) best.insert = insert;
+        if (round == 0 || hit < best.hit) best.hit = hit;
+        if (round == 0 || miss < best.miss) best.miss = miss;
+    }
+
+    //Keeps the lookups from being optimized away.
+    if (found == (size_t) -1) cerr << found << endl;
+    return best;
+}
+
+/**
+ * Runs both maps on one key set and prints a row for each.
+ * @param name The key set.
+ * @param keys The keys, in file order.
+ * @param misses Keys that aren't in the set.
+ * @param rounds The number of rounds.
+ */
+template <typename Key, typename Hash, typename Equal>
+static void runSet(const string& name, const vector<Key>& keys, const vector<Key>& misses, int rounds){
+    if (keys.empty() || misses.empty()) return;
+
+    vector<Key> lookups = keys;
+    shuffle(lookups.begin(), lookups.end(), mt19937(42));
+
+    Result flat = runMap<FlatHashMap<Key, uint32_t, Hash, Equal>>(keys, lookups, misses, rounds);
+    Result node = runMap<unordered_map<Key, uint32_t, Hash, Equal>>(keys, lookups, misses, rounds);
+    for (int i = 0; i < 2; i++){
+        const Result& result = (i == 0) ? flat : node;
+        cout << name << '\t' << keys.size() << '\t' << ((i == 0) ? "FlatHashMap" : "unordered_map") << '\t'
+             << (int) result.insert << '\t' << (int) result.hit << '\t' << (int) result.miss << endl;
+    }
+}
+
+/**
+ * Reads the key sets from a TA file and benchmarks each.
+ * @param argc The number of arguments.
+ * @param argv The TA file and the number of rounds.
+ * @return Return code.
+ */
+int main(int argc, const char *argv[]) {
+    int rounds = (argc > 2) ? atoi(argv[2]) : 10;
+    if (argc < 2 || rounds <= 0){
+        cerr << "Usage: bfx64-flatmap-bench file.ta [rounds]" << endl;
+        return 1;
+    }
+
+    ifstream in(argv[1], ios::binary);
+    if (!in.is_open()){
+        cerr << "Could not read " << argv[1] << "!" << endl;
+        return 1;
+    }
+    stringstream buffer;
+    buffer << in.rdbuf();
+    string text = buffer.str();
+
+    //Keys point into the file text, so lines are split in place.
+    vector<string_view> IDs, symbols;
+    vector<EdgeKey> edges;
+    const string_view SYMBOLS_MARKER = "symbols = \"";
+    bool tuples = false;
+    size_t start = 0;
+    while (start < text.size()){
+        size_t end = text.find('\n', start);
+        if (end == string::npos) end = text.size();
+        string_view line(text.data() + start, end - start);
+        start = end + 1;
+
+        if (line.compare(0, 10, "FACT TUPLE") == 0){
+            tuples = true;
+            continue;
+        } else if (line.compare(0, 14, "FACT ATTRIBUTE") == 0){
+            tuples = false;
+            continue;
+        }
+
+        if (tuples){
+            size_t first = line.find(' ');
+            size_t second = (first == string_view::npos) ? first : line.find(' ', first + 1);
+            if (second == string_view::npos) continue;
+
+            string_view head = line.substr(0, first);
+            string_view middle = line.substr(first + 1, second - first - 1);
+            string_view last = line.substr(second + 1);
+            if (head == "$INSTANCE") IDs.push_back(middle);
+            else edges.push_back(EdgeKey{middle, last, head});
+            continue;
+        }
+
+        size_t marker = line.find(SYMBOLS_MARKER);
+        if (marker == string_view::npos) continue;
+        string_view list = line.substr(marker + SYMBOLS_MARKER.size());
+        list = list.substr(0, list.find('"'));
+        while (!list.empty()){
+            size_t space = list.find(' ');
+            symbols.push_back(list.substr(0, space));
+            list.remove_prefix((space == string_view::npos) ? list.size() : space + 1);
+        }
+    }
+    sort(symbols.begin(), symbols.end());
+    symbols.erase(unique(symbols.begin(), symbols.end()), symbols.end());
+
+    //Misses share the shape of real keys but differ in their last byte (or relation).
+    vector<string> missText;
+    for (const vector<string_view>* set : {&IDs, &symbols}){
+        for (string_view key : *set) missText.push_back(string(key) + '~');
+    }
+    vector<string_view> missIDs, missSymbols;
+    for (size_t i = 0; i < missText.size(); i++){
+        ((i < IDs.size()) ? missIDs : missSymbols).push_back(missText[i]);
+    }
+    vector<EdgeKey> missEdges;
+    for (const EdgeKey& edge : edges) missEdges.push_back(EdgeKey{edge.src, edge.dst, "absent"});
+
+    cout << "keys\tcount\tmap\tinsert ns\thit ns\tmiss ns" << endl;
+    runSet<string_view, StringHash, StringEqual>("IDs", IDs, missIDs, rounds);
+    runSet<string_view, StringHash, StringEqual>("symbols", symbols, missSymbols, rounds);
+    runSet<EdgeKey, EdgeKeyHash, equal_to<EdgeKey>>("edges", edges, missEdges, rounds);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MemoryBench.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Benchmark for the memory a TAGraph takes. Builds a synthetic
+// graph whose IDs share long directory prefixes, like a real build
+// tree, and prints the peak resident set size once the graph is
+// built and again once it is finalized.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include "../Graph/TAGraph.h"
+
+using namespace std;
+
+/** Synthetic Graph Shape */
+const string ROOT = "/home/builder/workspace/projects/large-system/build/release/src";
+const int MODULES = 50;
+const int COMPONENTS = 4;
+const int FILES = 2000;
+const int EDGES_PER_NODE = 3;
+
+/**
+ * Gets the peak resident set size of the process.
+ * @return The peak in megabytes.
+ */
+static long peakMB(){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+}
+
+/**
+ * Gets the ID of a synthetic file.
+ * @param file The file number.
+ * @return The file ID.
+ */
+static string getFileID(int file){
+    return ROOT + "/module" + to_string(file % MODULES) + "/component" + to_string((file / MODULES) % COMPONENTS) +
+           "/source_file_" + to_string(file) + ".o";
+}
+
+/**
+ * Gets the mangled name of a synthetic function.
+ * @param function The function number.
+ * @return The mangled name.
+ */
+static string getMangle(int function){
+    return "_ZN9namespace5klass12method_name_" + to_string(function) + "Ev";
+}
+
+/**
+ * Builds the synthetic graph and prints its peak memory.
+ * @param argc The number of arguments.
+ * @param argv The number of function nodes.
+ * @return Return code.
+ */
+int main(int argc, const char *argv[]) {
+    int numNodes = (argc > 1) ? atoi(argv[1]) : 200000;
+    if (numNodes <= 0){
+        cerr << "Usage: bfx64-memory-bench [nodes]" << endl;
+        return 1;
+    }
+
+    //Subsystems, files, then the functions in each file.
+    TAGraph graph;
+    graph.addNode(ROOT, BFXNode::SUBSYSTEM, "src", "");
+    for (int i = 0; i < MODULES; i++){
+        string module = ROOT + "/module" + to_string(i);
+        graph.addNode(module, BFXNode::SUBSYSTEM, "module" + to_string(i), "");
+        graph.addEdge(ROOT, module, BFXEdge::CONTAINS);
+        for (int j = 0; j < COMPONENTS; j++){
+            string component = module + "/component" + to_string(j);
+            graph.addNode(component, BFXNode::SUBSYSTEM, "component" + to_string(j), "");
+            graph.addEdge(module, component, BFXEdge::CONTAINS);
+        }
+    }
+    for (int i = 0; i < FILES; i++){
+        string file = getFileID(i);
+        graph.addNode(file, BFXNode::FILE, "source_file_" + to_string(i) + ".o", "");
+        graph.addEdge(file.substr(0, file.rfind('/')), file, BFXEdge::CONTAINS);
+    }
+    for (int i = 0; i < numNodes; i++){
+        string file = getFileID(i % FILES);
+        string mangle = getMangle(i);
+        string ID = file + "[.text." + mangle + "+0x0]";
+        graph.addNode(ID, BFXNode::FUNCTION, "method_name_" + to_string(i), mangle);
+        graph.addEdge(file, ID, BFXEdge::CONTAINS);
+    }
+    for (int i = 0; i < numNodes * EDGES_PER_NODE; i++){
+        graph.addEdgeByMangle(getMangle(i % numNodes), getMangle((i * 7 + 13) % numNodes), BFXEdge::LINK);
+    }
+    cout << "built\t" << peakMB() << " MB" << endl;
+
+    graph.finalize();
+    cout << "finalized\t" << peakMB() << " MB" << endl;
+    return 0;
+}
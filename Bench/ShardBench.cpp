@@ -0,0 +1,115 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ShardBench.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Benchmark for concurrent TAGraph inserts and lookups. Builds a
+// synthetic graph with 1, 2, 4, ... threads up to a maximum and
+// prints the throughput at each thread count, so the scaling of the
+// sharded indexes can be measured on a given machine.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Graph/TAGraph.h"
+
+using namespace std;
+
+/** Synthetic Graph Shape */
+const int FILES_PER_DIR = 400;
+const int DIRS = 50;
+const int EDGES_PER_NODE = 3;
+
+/**
+ * Runs a function on a number of threads, each given its thread
+ * index, and times it.
+ * @param numThreads The number of threads.
+ * @param work The function to run.
+ * @return The elapsed seconds.
+ */
+static double timeThreads(int numThreads, const function<void(int)>& work){
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int i = 0; i < numThreads; i++) threads.push_back(thread(work, i));
+    for (thread& curr : threads) curr.join();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Builds the synthetic graph at each thread count and prints the
+ * node insert, edge insert and lookup rates.
+ * @param argc The number of arguments.
+ * @param argv The number of nodes and the maximum thread count.
+ * @return Return code.
+ */
+int main(int argc, const char *argv[]) {
+    int numNodes = (argc > 1) ? atoi(argv[1]) : 200000;
+    int maxThreads = (argc > 2) ? atoi(argv[2]) : 64;
+    if (numNodes <= 0 || maxThreads <= 0){
+        cerr << "Usage: bfx64-shard-bench [nodes] [max threads]" << endl;
+        return 1;
+    }
+
+    vector<string> IDs, mangles;
+    for (int i = 0; i < numNodes; i++){
+        IDs.push_back("/proj/src/dir" + to_string(i % DIRS) + "/file" + to_string(i % FILES_PER_DIR) +
+                      ".o[.text+0x" + to_string(i) + "]");
+        mangles.push_back("_Z12function_" + to_string(i) + "v");
+    }
+
+    cout << "threads\tnodes/s\tedges/s\tlookups/s" << endl;
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2){
+        TAGraph graph;
+        auto slice = [numNodes, numThreads](int index, int& first, int& last){
+            first = (int) ((long long) numNodes * index / numThreads);
+            last = (int) ((long long) numNodes * (index + 1) / numThreads);
+        };
+
+        double nodeTime = timeThreads(numThreads, [&](int index){
+            int first, last;
+            slice(index, first, last);
+            for (int i = first; i < last; i++) graph.addNode(IDs[i], BFXNode::FUNCTION, "f", mangles[i]);
+        });
+        double edgeTime = timeThreads(numThreads, [&](int index){
+            int first, last;
+            slice(index, first, last);
+            for (int i = first; i < last; i++){
+                for (int j = 1; j <= EDGES_PER_NODE; j++){
+                    graph.addEdgeByMangle(mangles[i], mangles[(i * 7 + j * 13) % numNodes], BFXEdge::LINK);
+                }
+            }
+        });
+        double lookupTime = timeThreads(numThreads, [&](int index){
+            int first, last;
+            slice(index, first, last);
+            for (int i = first; i < last; i++) graph.doesNodeExist(IDs[i]);
+        });
+
+        cout << numThreads << '\t' << (long long) (numNodes / nodeTime) << '\t'
+             << (long long) (numNodes * EDGES_PER_NODE / edgeTime) << '\t'
+             << (long long) (numNodes / lookupTime) << endl;
+    }
+
+    return 0;
+}
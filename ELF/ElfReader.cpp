@@ -27,8 +27,12 @@
 #include <iostream>
 #include <boost/filesystem.hpp>
 #include <elfio/elfio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <sstream>
 #include <map>
+#include <thread>
 #include "ElfReader.h"
 #include "../Runner/TAFunctions.h"
 
@@ -37,6 +41,8 @@ using namespace ELFIO;
 using namespace boost::filesystem;
 
 const int ElfReader::DUMP_DEFAULT = 100;
+const int ElfReader::BYTES_PER_SYMBOL = 400;
+const int ElfReader::EDGES_PER_SYMBOL = 3;
 
 /**
  * Constructor that creates an ElfReader based on a start
@@ -44,9 +50,11 @@ const int ElfReader::DUMP_DEFAULT = 100;
  * @param startDir The start directory for O files.
  * @param outputPath The output location for the TA file.
  * @param suppress Whether we suppress looking for a file.
+ * @param dumpFreq The number of files between purges (0 purges on the memory budget only).
+ * @param numThreads The number of extraction threads (0 uses every core).
  */
-ElfReader::ElfReader(string startDir, string outputPath, bool suppress, bool verbose, bool lowMemory, int dumpFreq)
-        : printer(PrintOperation(verbose)){
+ElfReader::ElfReader(string startDir, string outputPath, bool suppress, bool verbose, bool lowMemory, int dumpFreq,
+                     int numThreads) : printer(PrintOperation(verbose)){
     //Check if we have an empty directory.
     if (startDir.compare("") == 0){
         curPath = initial_path();
@@ -59,10 +67,26 @@ ElfReader::ElfReader(string startDir, string outputPath, bool suppress, bool ver
 
     //Set suppress.
     this->suppress = suppress;
+    this->graph = nullptr;
 
     //Sets low memory mode.
     this->lowMem = lowMemory;
     this->dumpFreq = dumpFreq;
+    this->memoryBudget = 0;
+    this->budgetTooSmall = false;
+    this->diskBacked = false;
+    this->collapseTemplates = false;
+    this->linkAttributes = false;
+    this->keepSymbols = false;
+    this->numFolded = 0;
+    this->granularity = FUNCTION;
+    this->shardIndex = 0;
+    this->shardCount = 1;
+    this->shardMode = BY_SIZE;
+
+    //Sets the number of threads.
+    if (numThreads <= 0) numThreads = (int) thread::hardware_concurrency();
+    this->numThreads = (numThreads <= 0) ? 1 : numThreads;
 }
 
 /**
@@ -72,15 +96,128 @@ ElfReader::~ElfReader(){
     delete graph;
 }
 
+/**
+ * Sets a snapshot file to write once the graph is finished.
+ * @param snapshotPath The snapshot path (empty for none).
+ */
+void ElfReader::setSnapshot(string snapshotPath){
+    this->snapshotPath = snapshotPath;
+}
+
+/**
+ * Sets the memory budget for the graph in low memory mode.
+ * The graph is purged whenever it grows past the budget.
+ * @param budget The budget in bytes (0 for none).
+ */
+void ElfReader::setMemoryBudget(size_t budget){
+    this->memoryBudget = budget;
+}
+
+/**
+ * Keeps the graph in a memory-mapped file instead of the heap,
+ * for graphs larger than physical memory.
+ * @param storageDir The directory for the graph file (empty for the temp directory).
+ */
+void ElfReader::setDiskBacked(string storageDir){
+    this->diskBacked = true;
+    this->storageDir = storageDir;
+}
+
+/**
+ * Folds the instantiations of each function template in an
+ * object file into a single node.
+ * @param collapse Whether to collapse templates.
+ */
+void ElfReader::setCollapseTemplates(bool collapse){
+    this->collapseTemplates = collapse;
+}
+
+/**
+ * Sets whether the TA file lists the symbols each entity defines
+ * and its references by name instead of as edges, so that it can
+ * be merged with TA files extracted separately.
+ * @param link Whether to write link attributes.
+ */
+void ElfReader::setLinkAttributes(bool link){
+    this->linkAttributes = link;
+}
+
+/**
+ * Sets whether the graph keeps every mangled name once it is
+ * finished, for output formats that store them.
+ * @param keep Whether to keep mangled names.
+ */
+void ElfReader::setKeepSymbols(bool keep){
+    this->keepSymbols = keep;
+}
+
+/**
+ * Sets the level nodes are extracted at. At the file and
+ * subsystem levels, symbols never get nodes; references are
+ * lifted straight onto the file or directory that defines them.
+ * @param level The granularity.
+ */
+void ElfReader::setGranularity(Granularity level){
+    this->granularity = level;
+}
+
+/**
+ * Restricts extraction to one shard of the object files. Every
+ * process given the same tree and shard count picks the same
+ * split, so the shards cover each file exactly once.
+ * @param index The shard to process (from 0).
+ * @param count The number of shards.
+ * @param mode Whether to balance shards by file size or split by path hash.
+ */
+void ElfReader::setShard(int index, int count, ShardMode mode){
+    this->shardIndex = index;
+    this->shardCount = count;
+    this->shardMode = mode;
+}
+
+/**
+ * Parses a shard given as index/count (e.g. 2/8).
+ * @param spec The shard string.
+ * @param index The shard index (from 0).
+ * @param count The number of shards.
+ * @return Whether the string was a valid shard.
+ */
+bool ElfReader::parseShard(const string& spec, int& index, int& count){
+    size_t slash = spec.find('/');
+    if (slash == string::npos || slash == 0 || slash + 1 == spec.size()) return false;
+
+    for (size_t i = 0; i < spec.size(); i++){
+        if (i != slash && !isdigit((unsigned char) spec[i])) return false;
+    }
+
+    try {
+        index = stoi(spec.substr(0, slash));
+        count = stoi(spec.substr(slash + 1));
+    } catch (...) {
+        return false;
+    }
+    return count > 0 && index < count;
+}
+
 /**
  * Driver method for the TA creation. Reads all O files and
  * then generates the TA file.
+ * @return Whether the TA file and any snapshot were written.
  */
-void ElfReader::read(vector<string> inputFiles, vector<string> removeFiles){
-    externalRef = map<string, vector<string>>();
-
+bool ElfReader::read(vector<string> inputFiles, vector<string> removeFiles){
     //Generate a new instance of the graph.
-    graph = new TAGraph(this->lowMem);
+    MappedArena* storage = nullptr;
+    if (diskBacked){
+        storage = new MappedArena(storageDir);
+        if (!storage->isOpen()){
+            printer.printStorageFailure(storageDir);
+            delete storage;
+            return false;
+        }
+    }
+    graph = new TAGraph(this->lowMem, storage);
+    graph->setLinkAttributes(linkAttributes);
+    graph->setKeepSymbols(keepSymbols);
 
     //Start by reading all the files.
     vector<path> objectFiles;
@@ -90,13 +227,13 @@ void ElfReader::read(vector<string> inputFiles, vector<string> removeFiles){
             curr = canonical(path(file));
         } catch (...){
             printer.printFileNotFound(file);
-            return;
+            return false;
         }
 
         //Check if the file exists.
         if (!boost::filesystem::exists(curr)) {
             printer.printFileNotFound(file);
-            return;
+            return false;
         } else {
             printer.printFileFound(file);
         }
@@ -105,16 +242,16 @@ void ElfReader::read(vector<string> inputFiles, vector<string> removeFiles){
     if (!suppress) {
         //Next, reads the directories.
         printer.printStartFileSearch();
-        vector<path> dirFiles = TAFunctions::getObjectFiles(graph, printer, curPath, path());
+        vector<path> dirFiles = TAFunctions::getObjectFiles(graph, printer, curPath, path(), granularity != SUBSYSTEM);
         objectFiles.insert(objectFiles.end(), dirFiles.begin(), dirFiles.end());
     }
 
     if (objectFiles.size() == 0 && !suppress){
         printer.printNoFiles();
-        return;
+        return false;
     } else if (objectFiles.size() == 0 && suppress){
         printer.printNoFiles();
-        return;
+        return false;
     }
 
     //Perform the removals.
@@ -124,7 +261,7 @@ void ElfReader::read(vector<string> inputFiles, vector<string> removeFiles){
             p = canonical(path(removal));
         } catch (...){
             printer.printFileNotFound(p.string());
-            return;
+            return false;
         }
         cout << "Removing " << p.string() << "...";
 
@@ -146,87 +283,262 @@ void ElfReader::read(vector<string> inputFiles, vector<string> removeFiles){
     //Finally check if we have a valid list.
     if (objectFiles.size() == 0){
         printer.printNoFiles();
-        return;
+        return false;
     }
     printer.printDoneFileSearch();
 
+    //Keep only this process's shard. An empty shard still writes its file nodes.
+    if (shardCount > 1){
+        size_t numTotal = objectFiles.size();
+        objectFiles = selectShard(objectFiles);
+        printer.printShard(shardIndex, shardCount, objectFiles.size(), numTotal);
+    }
+
     //Set the printer size.
     printer.setNumFiles((int) objectFiles.size());
 
+    //Size the graph indexes from the files we found.
+    reserveGraph(objectFiles);
+
     //Starts the printing process.
     printer.printStartProcess();
 
     //If we're in low memory mode, starts the TA dump.
     if (lowMem) {
-        bool succ = TAFunctions::startTAGeneration(outputDirectory);
+        bool succ = TAFunctions::startTAGeneration(outputDirectory, graph, numThreads);
         if (!succ) {
             printer.printTAFailure(outputDirectory);
-            return;
+            return false;
         }
     }
 
-    //Once found, we process each individually.
-    for (int i = 0; i < objectFiles.size(); i++){
-        printer.printFileProcess(objectFiles.at(i).string());
-        process(objectFiles.at(i));
-
-        //Check if we need to dump.
-        if ((i + 1) % dumpFreq == 0 && lowMem){
-            printer.printFileProcessSub(PrintOperation::Operation::PURGE);
-            bool succ = TAFunctions::dumpTAFile(graph);
-            if (!succ){
-                printer.printTAFailure(outputDirectory);
-                return;
-            }
-        }
+    //First find every definition, then link all references against them.
+    validFiles.assign(objectFiles.size(), 1);
+    if (!runPhase(DEFINITIONS, objectFiles) || !runPhase(REFERENCES, objectFiles)){
+        if (!budgetTooSmall) printer.printTAFailure(outputDirectory);
+        return false;
     }
     printer.printEndProcess();
+    if (collapseTemplates) printer.printTemplatesCollapsed(numFolded);
 
-    //Now, we resolve all undefined references.
-    printer.printResolving();
-    processUndefinedReferences();
-    printer.printDoneResolving();
+    //The graph is complete, so freeze it for output.
+    if (!lowMem) graph->finalize();
 
+    //Next, we generate the TA file. Low memory mode merges its runs.
+    bool succ;
+    if (lowMem){
+        succ = TAFunctions::dumpTAFile(graph);
+        if (succ) printer.printMerging();
+        succ = TAFunctions::endTAFile() && succ;
+    } else {
+        succ = TAFunctions::generateTAFile(outputDirectory, graph, numThreads);
+    }
 
-    //Next, we generate the TA file.
-    bool succ = (lowMem) ? TAFunctions::dumpTAFile(graph) : TAFunctions::generateTAFile(outputDirectory, graph);
     if (succ) {
         printer.printTASuccess(outputDirectory);
     } else {
         printer.printTAFailure(outputDirectory);
     }
-    if (lowMem) TAFunctions::endTAFile();
+
+    //Write the binary snapshot if requested.
+    if (snapshotPath.compare("") != 0){
+        if (TAFunctions::writeSnapshot(snapshotPath, graph)){
+            printer.printSnapshotSuccess(snapshotPath);
+        } else {
+            printer.printSnapshotFailure(snapshotPath);
+            succ = false;
+        }
+    }
+    return succ;
+}
+
+/**
+ * Picks the object files in this process's shard. By hash, each
+ * path goes to the shard its FNV-1a hash selects. By size, the
+ * largest files are dealt out first, each to the lightest shard,
+ * with ties broken by path.
+ * @param objectFiles Every object file found.
+ * @return The object files in this shard.
+ */
+vector<path> ElfReader::selectShard(const vector<path>& objectFiles){
+    vector<path> selected;
+    if (shardMode == BY_HASH){
+        for (const path& curr : objectFiles){
+            uint64_t hash = 14695981039346656037ULL;
+            for (char c : curr.string()){
+                hash ^= (unsigned char) c;
+                hash *= 1099511628211ULL;
+            }
+            if (hash % (uint64_t) shardCount == (uint64_t) shardIndex) selected.push_back(curr);
+        }
+        return selected;
+    }
+
+    vector<pair<uintmax_t, string>> files;
+    for (const path& curr : objectFiles){
+        boost::system::error_code ec;
+        uintmax_t size = file_size(curr, ec);
+        files.push_back(make_pair((ec) ? 0 : size, curr.string()));
+    }
+    sort(files.begin(), files.end(), [](const pair<uintmax_t, string>& a, const pair<uintmax_t, string>& b){
+        return (a.first != b.first) ? a.first > b.first : a.second < b.second;
+    });
+
+    vector<uintmax_t> loads((size_t) shardCount, 0);
+    for (const pair<uintmax_t, string>& file : files){
+        size_t lightest = (size_t) (min_element(loads.begin(), loads.end()) - loads.begin());
+        loads[lightest] += file.first;
+        if (lightest == (size_t) shardIndex) selected.push_back(path(file.second));
+    }
+    return selected;
+}
+
+/**
+ * Estimates the size of the final graph from the object files
+ * found during discovery and reserves the graph indexes up front.
+ * @param objectFiles The object files that will be processed.
+ */
+void ElfReader::reserveGraph(vector<path> objectFiles){
+    uintmax_t totalBytes = 0;
+    for (path curr : objectFiles){
+        boost::system::error_code ec;
+        uintmax_t size = file_size(curr, ec);
+        if (!ec) totalBytes += size;
+    }
+
+    size_t numSymbols = objectFiles.size() + (size_t) (totalBytes / BYTES_PER_SYMBOL);
+    if (granularity == FUNCTION){
+        graph->reserve(numSymbols, numSymbols * EDGES_PER_SYMBOL, numSymbols);
+    } else {
+        //Only files and directories get nodes, but every symbol is still indexed.
+        graph->reserve(objectFiles.size(), objectFiles.size() * EDGES_PER_SYMBOL, numSymbols);
+    }
 }
 
 /**
- * Processes a singular object file by
- * inspecting the symbol table and then
- * examining the relocations in the file.
+ * Runs one extraction phase over all object files. In low memory
+ * mode the files are processed in batches with a purge after each.
+ * A batch ends early when the graph outgrows the memory budget.
+ * @param phase The phase to run.
+ * @param objectFiles The object files to process.
+ * @return Whether every purge succeeded and the budget could be kept.
+ */
+bool ElfReader::runPhase(Phase phase, const vector<path>& objectFiles){
+    bool byCount = lowMem && (dumpFreq > 0 || memoryBudget == 0);
+    size_t batchSize = (byCount) ? (size_t) max(dumpFreq, 1) : objectFiles.size();
+
+    for (size_t begin = 0; begin < objectFiles.size();){
+        size_t end = min(begin + batchSize, objectFiles.size());
+        size_t stop = processBatch(phase, objectFiles, begin, end);
+        if (budgetTooSmall){
+            printer.printBudgetFailure(memoryBudget, graph->getRetainedBytes());
+            return false;
+        }
+
+        //Check if we need to dump.
+        if ((byCount && stop - begin == batchSize) || overBudget()){
+            printer.printFileProcessSub(PrintOperation::Operation::PURGE);
+            if (!TAFunctions::dumpTAFile(graph)) return false;
+        }
+        begin = stop;
+    }
+
+    return true;
+}
+
+/**
+ * Processes a range of object files on the worker threads. Each
+ * thread takes the next unclaimed file until none are left or the
+ * graph is over the memory budget. Claimed files always finish.
+ * @param phase The phase to run.
+ * @param objectFiles The object files.
+ * @param begin The first file of the batch.
+ * @param end One past the last file of the batch.
+ * @return One past the last file processed.
+ */
+size_t ElfReader::processBatch(Phase phase, const vector<path>& objectFiles, size_t begin, size_t end){
+    size_t workers = min((size_t) numThreads, end - begin);
+    atomic<size_t> next(begin);
+    atomic<bool> full(false);
+
+    auto worker = [&](){
+        while (!full){
+            size_t i = next++;
+            if (i >= end) break;
+
+            process(phase, objectFiles.at(i), i);
+            if (overBudget()) full = true;
+        }
+    };
+
+    //Run small batches on this thread.
+    if (workers <= 1){
+        worker();
+    } else {
+        vector<thread> threads;
+        for (size_t i = 0; i < workers; i++) threads.push_back(thread(worker));
+        for (thread& curr : threads) curr.join();
+    }
+
+    return min(next.load(), end);
+}
+
+/**
+ * Checks whether the graph has outgrown the memory budget. Only
+ * nodes and edges can be purged, so they get whatever the mangle
+ * list and node filter leave of the budget. If those alone fill
+ * it, no purge can help and extraction stops.
+ * @return Whether a purge is needed.
+ */
+bool ElfReader::overBudget(){
+    if (!lowMem || memoryBudget == 0) return false;
+
+    size_t retained = graph->getRetainedBytes();
+    if (retained >= memoryBudget){
+        budgetTooSmall = true;
+        return true;
+    }
+    return graph->getLiveBytes() > memoryBudget - retained;
+}
+
+/**
+ * Processes a singular object file for one phase. The
+ * definitions phase inspects the symbol table and the
+ * references phase examines the relocations in the file.
+ * @param phase The phase to run.
  * @param objectFile The object file being examined.
+ * @param fileNum The index of the file.
  */
-void ElfReader::process(path objectFile){
+void ElfReader::process(Phase phase, path objectFile, size_t fileNum){
+    if (phase == REFERENCES && !validFiles[fileNum]) return;
+    if (phase == DEFINITIONS) printer.printFileProcess(objectFile.string());
+    else printer.printFileLink(objectFile.string());
+
     //Start by reading the object file.
     elfio reader;
     if (!reader.load(objectFile.string())){
+        validFiles[fileNum] = 0;
         printer.printFileProcessSub(PrintOperation::INVALID);
         return;
     }
 
     //Next, print the file properties.
-    PrintOperation::Bit bitType;
-    PrintOperation::Endian endianType;
-    if (reader.get_class() == ELFCLASS32){
-        bitType = PrintOperation::x86;
-    } else {
-        bitType = PrintOperation::x64;
-    }
+    if (phase == DEFINITIONS){
+        PrintOperation::Bit bitType;
+        PrintOperation::Endian endianType;
+        if (reader.get_class() == ELFCLASS32){
+            bitType = PrintOperation::x86;
+        } else {
+            bitType = PrintOperation::x64;
+        }
 
-    if (reader.get_encoding() == ELFDATA2LSB){
-        endianType = PrintOperation::LITTLE;
-    } else {
-        endianType = PrintOperation::BIG;
+        if (reader.get_encoding() == ELFDATA2LSB){
+            endianType = PrintOperation::LITTLE;
+        } else {
+            endianType = PrintOperation::BIG;
+        }
+        printer.printFileProcessSub(bitType, endianType);
     }
-    printer.printFileProcessSub(bitType, endianType);
 
     //We find the symbol table in our file.
     Elf_Half sec_num = reader.sections.size();
@@ -234,25 +546,30 @@ void ElfReader::process(path objectFile){
         section* currSec = reader.sections[i];
 
         //Check if we have the symbol table.
-        if (currSec->get_type() == SHT_SYMTAB){
+        if (currSec->get_type() != SHT_SYMTAB) continue;
+
+        if (phase == DEFINITIONS){
             //Process the symbol table initially.
             printer.printFileProcessSub(PrintOperation::INITIAL);
-            processSymbolTable(objectFile, currSec);
-
+            processSymbolTable(objectFile, reader, currSec);
+        } else {
             //Link references.
-            printer.printFileProcessSub(PrintOperation::LINK);
-            resolveReferences(objectFile, currSec);
+            resolveReferences(reader, currSec);
         }
     }
 }
 
 /**
  * Helper method that examines the symbol table and generates nodes
- * for the graph.
+ * for the graph. When collapsing templates, every instantiation of
+ * a function template in the file reuses the ID of the first one,
+ * so its mangled name (and with it, its references) lands on the
+ * same node.
  * @param oFile Object file being examined.
+ * @param reader The loaded object file.
  * @param symTab Symbol table section pointer.
  */
-void ElfReader::processSymbolTable(path oFile, section* symTab){
+void ElfReader::processSymbolTable(path oFile, elfio& reader, section* symTab){
     //Create variables for symbol table information.
     string name;
     Elf64_Addr value;
@@ -263,11 +580,14 @@ void ElfReader::processSymbolTable(path oFile, section* symTab){
     unsigned char other;
 
     //Generate a symbol table accessor.
-    elfio reader = elfio();
-    reader.load(oFile.string());
     const symbol_section_accessor symbols(reader, symTab);
+    string fileName = canonical(oFile.string()).string();
 
     bool IDsuccess;
+    map<string, string> templates;
+
+    //Coarse graphs lift every symbol onto its file or directory.
+    string owner = (granularity == SUBSYSTEM) ? path(fileName).parent_path().string() : fileName;
 
     //Next, inspect each entry in the table.
     for (unsigned int i = 0; i < symbols.get_symbols_num(); i++){
@@ -282,12 +602,29 @@ void ElfReader::processSymbolTable(path oFile, section* symTab){
 
         //Next, check what type of symbol we're dealing with.
         if (type == STT_FUNC || type == STT_OBJECT) {
+            if (granularity != FUNCTION){
+                if (reader.sections[section_index] != nullptr) graph->addAlias(owner, name);
+                continue;
+            }
+
             //Generate a UNIQUE ID for the symtab object.
-            string ID = generateID(oFile.string(), section_index, value, IDsuccess);
+            string ID = generateID(oFile.string(), reader, section_index, value, IDsuccess);
             if (!IDsuccess) continue;
 
             string demName = demangleName(name.c_str());
-            string fileName = canonical(oFile.string()).string();
+
+            //Fold template instantiations onto the first one seen.
+            if (collapseTemplates && type == STT_FUNC){
+                string tmplName = templateName(demName);
+                if (tmplName.compare("") != 0){
+                    auto tmpl = templates.insert(make_pair(tmplName, ID)).first;
+                    if (tmpl->second.compare(ID) != 0){
+                        ID = tmpl->second;
+                        numFolded++;
+                    }
+                    demName = tmplName;
+                }
+            }
 
             //Add entry into our graph. Ensure that we have
             graph->addNode(ID, (type == STT_FUNC) ? BFXNode::FUNCTION : BFXNode::OBJECT, demName, name);
@@ -306,11 +643,12 @@ void ElfReader::processSymbolTable(path oFile, section* symTab){
 
 /**
  * Helper method that resolves references from the symbol table.
- * Only works if the symbols have all being examined first.
- * @param oFile Object file being examined.
+ * Every definition has been indexed by the time this runs, so each
+ * reference is linked straight away.
+ * @param reader The loaded object file.
  * @param symTab Symbol table section pointer.
  */
-void ElfReader::resolveReferences(path oFile, section* symTable){
+void ElfReader::resolveReferences(elfio& reader, section* symTable){
     //Create variables for symbol table information.
     string name;
     Elf64_Addr value;
@@ -321,10 +659,12 @@ void ElfReader::resolveReferences(path oFile, section* symTable){
     unsigned char other;
 
     //Generate a symbol table accessor.
-    elfio reader = elfio();
-    reader.load(oFile.string());
     const symbol_section_accessor symbols(reader, symTable);
 
+    //Relocation sections are looked up and read once per file.
+    map<Elf_Half, int> relocSections;
+    map<int, vector<RelocEntry>> relocations;
+
     //Reiterate and inspect each entry.
     for (unsigned int i = 0; i < symbols.get_symbols_num(); i++){
         //Read the associated symbol.
@@ -332,73 +672,30 @@ void ElfReader::resolveReferences(path oFile, section* symTable){
         if (type != STT_FUNC && type != STT_OBJECT) continue;
 
         //Find the relocation entry.
-        int relocation_num = getRelocationSection(oFile.string(), section_index);
+        auto secIt = relocSections.find(section_index);
+        if (secIt == relocSections.end()){
+            secIt = relocSections.insert(make_pair(section_index, getRelocationSection(reader, section_index))).first;
+        }
+        int relocation_num = secIt->second;
         if (relocation_num == -1) continue;
 
-        //Generate a relocation accessor.
-        elfio relReader = elfio();
-        relReader.load(oFile.string());
-        section* currSection = relReader.sections[relocation_num];
-        const relocation_section_accessor relInfo(relReader, currSection);
-
-        //Variables for relocation entry.
-        Elf64_Addr offset;
-        Elf64_Addr symbolValue;
-        string symbolName;
-        Elf_Word type;
-        Elf_Sxword addend;
-        Elf_Sxword calcValue;
-
-        //Now process the relocations.
-        for (unsigned int i = 0; i < relInfo.get_entries_num(); i++) {
-            //Get the value.
-            relInfo.get_entry(i, offset, symbolValue, symbolName, type, addend, calcValue);
-
-            //Check the address.
-            if (isValidReloc(value, value + size, offset)){
-                if (symbolName.compare("") == 0 ||
-                        graph->doesMangleEdgeExist(name, symbolName)) continue;
-
-                //Add an edge from that node to the ID of the other node.
-                bool result = graph->addEdgeByMangle(name, symbolName, BFXEdge::LINK);
-
-                //Check if the edge was added.
-                if (!result){
-                    //We add it to our external reference graph.
-                    if (externalRef.find(name) == externalRef.end()){
-                        //Create a new vector and add it.
-                        externalRef[name] = vector<string>();
-                    }
-
-                    //Add it to our reference list.
-                    externalRef[name].push_back(symbolName);
-                }
-            }
+        auto relIt = relocations.find(relocation_num);
+        if (relIt == relocations.end()){
+            relIt = relocations.insert(make_pair(relocation_num, readRelocations(reader, relocation_num))).first;
         }
-    }
-}
-
-/**
- * Examines all references that were not found
- * during the first pass through the O files.
- * The process function needs to be used on all
- * object files before this function can be used.
- */
-void ElfReader::processUndefinedReferences(){
-    map<string, vector<string>>::iterator it;
-
-    //We iterate through the map.
-    for (it = externalRef.begin(); it != externalRef.end(); it++){
-        //Get the ID.
-        string srcMangle = it->first;
-        vector<string> dstMangles = it->second;
-
-        //Iterate through our vector to add all references.
-        for (int i = 0; i < dstMangles.size(); i++){
-            string dstMangle = dstMangles.at(i);
-
-            //Add the edge.
-            bool result = graph->addEdgeByMangle(srcMangle, dstMangle, BFXEdge::LINK);
+        const vector<RelocEntry>& entries = relIt->second;
+
+        //Now process the relocations that fall inside the symbol.
+        auto curr = lower_bound(entries.begin(), entries.end(), RelocEntry(value, string()));
+        for (; curr != entries.end() && isValidReloc(value, value + size, curr->first); curr++){
+            if (curr->second.compare("") == 0) continue;
+
+            //Add an edge from that node to the ID of the other node.
+            if (linkAttributes){
+                graph->addLink(name, curr->second);
+            } else {
+                graph->addEdgeByMangle(name, curr->second, BFXEdge::LINK);
+            }
         }
     }
 }
@@ -407,17 +704,14 @@ void ElfReader::processUndefinedReferences(){
  * Generates an ID for the object. This is based on the file it is in
  * and the location in the O file. Different than the mangled name.
  * @param path The O file location.
+ * @param reader The loaded object file.
  * @param sectionNum The section number that the symbol exists.
  * @param addr The address that it starts at in that section.
  * @return A string ID generated.
  */
-string ElfReader::generateID(string path, Elf_Half sectionNum, Elf64_Addr addr, bool &success){
+string ElfReader::generateID(string path, elfio& reader, Elf_Half sectionNum, Elf64_Addr addr, bool &success){
     string ID = path + "[";
 
-    //Generate the reader.
-    elfio reader = elfio();
-    reader.load(path);
-
     //Next, get the associated section.
     section* secVal = reader.sections[sectionNum];
     if (secVal == nullptr) {
@@ -461,17 +755,76 @@ string ElfReader::demangleName(const char* mangledName){
     return demangled;
 }
 
+/**
+ * Gets the name of the template a demangled function belongs to.
+ * Template arguments are dropped, as are the parameters and the
+ * return type, so int max<int>(int, int) gives max<>.
+ * @param demName The demangled function name.
+ * @return The template name, or an empty string if it isn't an instantiation.
+ */
+string ElfReader::templateName(const string& demName){
+    static const string OPERATOR = "operator";
+    static const string ANONYMOUS = "(anonymous namespace)";
+    static const string OPERATOR_CHARS = "<>=!+-*/%^&|~,[]";
+
+    //Drop every template argument list.
+    string name;
+    int angles = 0;
+    bool isTemplate = false;
+    for (size_t i = 0; i < demName.size(); i++){
+        char curr = demName[i];
+
+        //Operator names like operator<< aren't brackets.
+        if (angles == 0 && demName.compare(i, OPERATOR.size(), OPERATOR) == 0 &&
+                (i == 0 || !(isalnum(demName[i - 1]) || demName[i - 1] == '_'))){
+            size_t end = i + OPERATOR.size();
+            while (end < demName.size() && OPERATOR_CHARS.find(demName[end]) != string::npos) end++;
+            if (demName.compare(end, 2, "()") == 0) end += 2;
+            name += demName.substr(i, end - i);
+            i = end - 1;
+            continue;
+        }
+
+        if (curr == '<'){
+            if (angles++ == 0) name += "<>";
+            isTemplate = true;
+        } else if (curr == '>' && angles > 0){
+            angles--;
+        } else if (angles == 0){
+            name += curr;
+        }
+    }
+    if (!isTemplate) return string();
+
+    //Cut off the parameter list and find where the qualified name starts.
+    size_t params = string::npos;
+    size_t start = 0;
+    int parens = 0;
+    for (size_t i = 0; i < name.size(); i++){
+        if (name[i] == '('){
+            if (parens == 0 && name.compare(i, ANONYMOUS.size(), ANONYMOUS) != 0) params = i;
+            parens++;
+        } else if (name[i] == ')'){
+            parens--;
+        } else if (name[i] == ' ' && parens == 0 && params == string::npos && name.compare(i + 1, 1, "<") != 0){
+            //The last space before the parameters ends the return type.
+            start = i + 1;
+        }
+    }
+    if (params == string::npos) params = name.size();
+    if (params <= start) return string();
+
+    return name.substr(start, params - start);
+}
+
 /**
  * Gets the relocation section for an associated section.
  * If the section cannot be found, returns -1.
- * @param path The O file.
+ * @param reader The loaded object file.
  * @param secNum The section num.
  * @return A section num indicating where the relocation section is.
  */
-int ElfReader::getRelocationSection(string path, Elf_Half secNum){
-    elfio reader = elfio();
-    reader.load(path);
-
+int ElfReader::getRelocationSection(elfio& reader, Elf_Half secNum){
     //Get the name of the section.
     auto sec = reader.sections[secNum];
     if (sec == nullptr) return -1;
@@ -494,6 +847,35 @@ int ElfReader::getRelocationSection(string path, Elf_Half secNum){
     return -1;
 }
 
+/**
+ * Reads the entries of a relocation section sorted by offset so
+ * the relocations inside a symbol can be found by binary search.
+ * @param reader The loaded object file.
+ * @param relocNum The relocation section num.
+ * @return The relocation offsets and symbol names.
+ */
+vector<ElfReader::RelocEntry> ElfReader::readRelocations(elfio& reader, int relocNum){
+    const relocation_section_accessor relInfo(reader, reader.sections[relocNum]);
+
+    //Variables for relocation entry.
+    Elf64_Addr offset;
+    Elf64_Addr symbolValue;
+    string symbolName;
+    Elf_Word type;
+    Elf_Sxword addend;
+    Elf_Sxword calcValue;
+
+    vector<RelocEntry> entries;
+    entries.reserve(relInfo.get_entries_num());
+    for (unsigned int i = 0; i < relInfo.get_entries_num(); i++){
+        relInfo.get_entry(i, offset, symbolValue, symbolName, type, addend, calcValue);
+        entries.push_back(RelocEntry(offset, symbolName));
+    }
+
+    sort(entries.begin(), entries.end());
+    return entries;
+}
+
 /**
  * Checks whether the relocation is being applied to the current object.
  * @param startPos The start address of the object.
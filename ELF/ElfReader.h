@@ -29,24 +29,54 @@
 
 #include <boost/filesystem.hpp>
 #include <elfio/elfio.hpp>
+#include <atomic>
 #include <string>
-#include <map>
+#include <vector>
 #include "../Graph/TAGraph.h"
 #include "../Print/PrintOperation.h"
 
 class ElfReader {
 public:
+    /** Level Nodes Are Extracted At */
+    enum Granularity { FUNCTION, FILE, SUBSYSTEM };
+
+    /** How Object Files Are Split Into Shards */
+    enum ShardMode { BY_SIZE, BY_HASH };
+
     /** Constructor / Destructor */
-    ElfReader(std::string startDir, std::string outPath, bool suppress, bool verbose, bool lowMemory, int dumpFreq = ElfReader::DUMP_DEFAULT);
+    ElfReader(std::string startDir, std::string outPath, bool suppress, bool verbose, bool lowMemory,
+              int dumpFreq = ElfReader::DUMP_DEFAULT, int numThreads = 0);
     ~ElfReader();
 
     /** Generation Method */
-    void read(std::vector<std::string> insertFiles, std::vector<std::string> removeFiles);
+    bool read(std::vector<std::string> insertFiles, std::vector<std::string> removeFiles);
+
+    /** Output Options */
+    void setSnapshot(std::string snapshotPath);
+    void setMemoryBudget(size_t budget);
+    void setDiskBacked(std::string storageDir);
+    void setCollapseTemplates(bool collapse);
+    void setLinkAttributes(bool link);
+    void setKeepSymbols(bool keep);
+    void setGranularity(Granularity level);
+    void setShard(int index, int count, ShardMode mode);
+
+    /** Option Parsing */
+    static bool parseShard(const std::string& spec, int& index, int& count);
 
     static const int DUMP_DEFAULT;
 private:
+    /** Extraction Phases */
+    enum Phase { DEFINITIONS, REFERENCES };
+
+    /** Relocation Entry Sorted by Offset */
+    typedef std::pair<ELFIO::Elf64_Addr, std::string> RelocEntry;
+
+    /** Sizing Estimates */
+    static const int BYTES_PER_SYMBOL;
+    static const int EDGES_PER_SYMBOL;
+
     /** Private Variables */
-    std::map<std::string, std::vector<std::string>> externalRef;
     const std::string REL_PREFIX[2] = {".rel", ".rela"};
     std::string outputDirectory;
     boost::filesystem::path curPath;
@@ -55,17 +85,39 @@ private:
     PrintOperation printer;
     bool lowMem;
     int dumpFreq;
+    size_t memoryBudget;
+    std::atomic<bool> budgetTooSmall;
+    bool diskBacked;
+    std::string storageDir;
+    bool collapseTemplates;
+    bool linkAttributes;
+    bool keepSymbols;
+    std::atomic<size_t> numFolded;
+    Granularity granularity;
+    int shardIndex;
+    int shardCount;
+    ShardMode shardMode;
+    int numThreads;
+    std::string snapshotPath;
+    std::vector<char> validFiles;
 
     /** Helper Methods to Read */
-    void process(boost::filesystem::path objectFile);
-    void processSymbolTable(boost::filesystem::path oFile, ELFIO::section* symTab);
-    void resolveReferences(boost::filesystem::path oFile, ELFIO::section* symTab);
-    void processUndefinedReferences();
+    void reserveGraph(std::vector<boost::filesystem::path> objectFiles);
+    std::vector<boost::filesystem::path> selectShard(const std::vector<boost::filesystem::path>& objectFiles);
+    bool runPhase(Phase phase, const std::vector<boost::filesystem::path>& objectFiles);
+    size_t processBatch(Phase phase, const std::vector<boost::filesystem::path>& objectFiles, size_t begin, size_t end);
+    bool overBudget();
+    void process(Phase phase, boost::filesystem::path objectFile, size_t fileNum);
+    void processSymbolTable(boost::filesystem::path oFile, ELFIO::elfio& reader, ELFIO::section* symTab);
+    void resolveReferences(ELFIO::elfio& reader, ELFIO::section* symTab);
 
     /** Sub Helper Methods */
-    std::string generateID(std::string path, ELFIO::Elf_Half sectionNum, ELFIO::Elf64_Addr addr, bool& success);
+    std::string generateID(std::string path, ELFIO::elfio& reader, ELFIO::Elf_Half sectionNum,
+                           ELFIO::Elf64_Addr addr, bool& success);
     std::string demangleName(const char* mangledName);
-    int getRelocationSection(std::string path, ELFIO::Elf_Half secNum);
+    static std::string templateName(const std::string& demName);
+    int getRelocationSection(ELFIO::elfio& reader, ELFIO::Elf_Half secNum);
+    std::vector<RelocEntry> readRelocations(ELFIO::elfio& reader, int relocNum);
     bool isValidReloc(ELFIO::Elf64_Addr startPos, ELFIO::Elf64_Addr endPos, ELFIO::Elf64_Addr relocPos);
 };
 
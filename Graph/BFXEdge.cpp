@@ -24,6 +24,8 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <memory_resource>
+#include <new>
 #include <string>
 #include "BFXEdge.h"
 
@@ -36,29 +38,43 @@ using namespace std;
  * @param type The type of edge.
  */
 BFXEdge::BFXEdge(BFXNode* src, BFXNode* dst, EdgeType type){
-    this->lowMem = false;
     this->src = src;
     this->dst = dst;
+    this->IDs = nullptr;
     this->type = type;
+    this->count = 1;
 }
 
 /**
- * Creates a new edge for low memory mode.
+ * Creates a new edge for low memory mode. Only these edges keep
+ * copies of their endpoint IDs, allocated with their suffixes
+ * from the graph's storage, so edges between nodes stay small.
  * @param src The source to add.
  * @param dst The destination node.
  * @param type The type of edge to add.
+ * @param memory Where the endpoint IDs are allocated.
  */
-BFXEdge::BFXEdge(string src, string dst, EdgeType type){
-    this->lowMem = true;
-    this->sourceID = src;
-    this->destinationID = dst;
+BFXEdge::BFXEdge(const CompactIDView& src, const CompactIDView& dst, EdgeType type, pmr::memory_resource* memory){
+    this->src = nullptr;
+    this->dst = nullptr;
+    this->IDs = pmr::polymorphic_allocator<EndpointIDs>(memory).allocate(1);
+    new (IDs) EndpointIDs{CompactID{src.path, pmr::string(src.suffix, memory)},
+                          CompactID{dst.path, pmr::string(dst.suffix, memory)}};
     this->type = type;
+    this->count = 1;
 }
 
 /**
- * Default destructor.
+ * Destructor. Frees the endpoint IDs of a low memory edge back
+ * to the storage their suffixes came from.
  */
-BFXEdge::~BFXEdge() { }
+BFXEdge::~BFXEdge() {
+    if (IDs == nullptr) return;
+
+    pmr::memory_resource* memory = IDs->src.suffix.get_allocator().resource();
+    IDs->~EndpointIDs();
+    pmr::polymorphic_allocator<EndpointIDs>(memory).deallocate(IDs, 1);
+}
 
 /**
  * Lookup function to translate the type enum
@@ -66,23 +82,44 @@ BFXEdge::~BFXEdge() { }
  * @param type The enum value.
  * @return The string equivalent of that enum.
  */
-string BFXEdge::getTypeString(EdgeType type){
+const string& BFXEdge::getTypeString(EdgeType type){
+    static const string CONTAINS_STR = "contain";
+    static const string LINK_STR = "reference";
+    static const string UNKNOWN_STR = "unknown";
+
     //Simply lookup the edge type value.
     if (type == EdgeType::CONTAINS){
-        return "contain";
+        return CONTAINS_STR;
     } else if (type == EdgeType::LINK){
-        return "reference";
+        return LINK_STR;
     }
 
     //If all else fails, return default.
-    return "unknown";
+    return UNKNOWN_STR;
+}
+
+/**
+ * Gets the edge type named by a TA relation.
+ * @param str The relation name.
+ * @param type The edge type.
+ * @return Whether the relation names an edge type.
+ */
+bool BFXEdge::getTypeFromString(string_view str, EdgeType& type){
+    if (str == getTypeString(EdgeType::CONTAINS)){
+        type = EdgeType::CONTAINS;
+        return true;
+    } else if (str == getTypeString(EdgeType::LINK)){
+        type = EdgeType::LINK;
+        return true;
+    }
+    return false;
 }
 
 /**
  * Gets the source node.
  * @return The source node.
  */
-BFXNode* BFXEdge::getSource(){
+BFXNode* BFXEdge::getSource() const {
     return src;
 }
 
@@ -90,7 +127,7 @@ BFXNode* BFXEdge::getSource(){
  * Gets the destination node.
  * @return The destination node.
  */
-BFXNode* BFXEdge::getDestination(){
+BFXNode* BFXEdge::getDestination() const {
     return dst;
 }
 
@@ -98,24 +135,49 @@ BFXNode* BFXEdge::getDestination(){
  * Gets the edge type.
  * @return The edge type.
  */
-BFXEdge::EdgeType BFXEdge::getType(){
+BFXEdge::EdgeType BFXEdge::getType() const {
     return type;
 }
 
 /**
  * Gets the source ID.
  */
-string BFXEdge::getSrcID(){
-    if (lowMem) return sourceID;
-    return src->getID();
+CompactIDView BFXEdge::getSrcID() const {
+    if (src == nullptr) return IDs->src.view();
+    return src->getID().view();
 }
 
 /**
  * Gets the destination ID.
  */
-string BFXEdge::getDstID(){
-    if (lowMem) return destinationID;
-    return dst->getID();
+CompactIDView BFXEdge::getDstID() const {
+    if (dst == nullptr) return IDs->dst.view();
+    return dst->getID().view();
+}
+
+/**
+ * Gets the number of times the edge was added. For
+ * references, this is the number of relocations from the
+ * source symbol to the destination.
+ * @return The reference count.
+ */
+uint32_t BFXEdge::getCount() const {
+    return count;
+}
+
+/**
+ * Records another occurrence of the edge.
+ */
+void BFXEdge::incrementCount(){
+    count++;
+}
+
+/**
+ * Sets the number of references the edge stands for.
+ * @param nCount The new count.
+ */
+void BFXEdge::setCount(uint32_t nCount){
+    count = nCount;
 }
 
 /**
@@ -123,7 +185,6 @@ string BFXEdge::getDstID(){
  * @param nSrc A pointer to the source node.
  */
 void BFXEdge::setSource(BFXNode* nSrc){
-    lowMem = false;
     src = nSrc;
 }
 
@@ -132,7 +193,6 @@ void BFXEdge::setSource(BFXNode* nSrc){
  * @param nDst A pointer to the destination node.
  */
 void BFXEdge::setDestination(BFXNode* nDst){
-    lowMem = false;
     dst = nDst;
 }
 
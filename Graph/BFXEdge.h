@@ -36,30 +36,42 @@ public:
 
     /** Constructor / Destructor */
     BFXEdge(BFXNode* src, BFXNode* dst, EdgeType type);
-    BFXEdge(std::string src, std::string dst, EdgeType type);
+    BFXEdge(const CompactIDView& src, const CompactIDView& dst, EdgeType type, std::pmr::memory_resource* memory);
     ~BFXEdge();
 
+    BFXEdge(const BFXEdge&) = delete;
+    BFXEdge& operator=(const BFXEdge&) = delete;
+
     /** Lookup Method */
-    static std::string getTypeString(EdgeType type);
+    static const std::string& getTypeString(EdgeType type);
+    static bool getTypeFromString(std::string_view str, EdgeType& type);
 
     /** Getters and Setters */
-    BFXNode* getSource();
-    BFXNode* getDestination();
-    BFXEdge::EdgeType getType();
-    std::string getSrcID();
-    std::string getDstID();
+    BFXNode* getSource() const;
+    BFXNode* getDestination() const;
+    BFXEdge::EdgeType getType() const;
+    CompactIDView getSrcID() const;
+    CompactIDView getDstID() const;
+    uint32_t getCount() const;
+    void incrementCount();
+    void setCount(uint32_t nCount);
     void setSource(BFXNode* nSrc);
     void setDestination(BFXNode* nDst);
     void setType(EdgeType nType);
 
 private:
+    /** Endpoint IDs (Only Allocated for Low Memory Edges) */
+    struct EndpointIDs {
+        CompactID src;
+        CompactID dst;
+    };
+
     /** Private Variables */
     BFXNode* src;
     BFXNode* dst;
+    EndpointIDs* IDs;
     EdgeType type;
-    bool lowMem;
-    std::string sourceID;
-    std::string destinationID;
+    uint32_t count;
 };
 
 
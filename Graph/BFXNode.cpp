@@ -30,17 +30,19 @@ using namespace std;
 
 /**
  * Creates a new BFX node.
- * @param ID The ID of the node.
+ * @param ID The ID of the node (split on the graph's path trie).
  * @param type The type of node.
  * @param name The name of the node (unmangled).
  * @param mangledNames A vector of unmangled values (all should tranlsate to name).
+ * @param memory Where the ID suffix, names and adjacency lists are allocated.
  */
-BFXNode::BFXNode(string ID, NodeType type, string name, vector<string> mangledNames){
+BFXNode::BFXNode(CompactID ID, NodeType type, string_view name, const vector<string>& mangledNames,
+                 pmr::memory_resource* memory) :
+        ID{ID.path, pmr::string(ID.suffix, memory)}, name(name, memory), mangledNames(memory), outEdges(memory),
+        inEdges(memory) {
     //Sets up all the fields.
-    this->ID = ID;
     this->type = type;
-    this->name = name;
-    this->mangledNames = mangledNames;
+    for (const string& curr : mangledNames) this->mangledNames.emplace_back(curr);
 }
 
 /**
@@ -53,28 +55,72 @@ BFXNode::~BFXNode(){ }
  * @param type The type to lookup.
  * @return The string equivalent.
  */
-string BFXNode::getTypeString(NodeType type){
+const string& BFXNode::getTypeString(NodeType type){
+    static const string FILE_STR = "cObjectFile";
+    static const string FUNCTION_STR = "cFunction";
+    static const string OBJECT_STR = "cObject";
+    static const string SUBSYSTEM_STR = "cSubSystem";
+    static const string ROOT_STR = "cRoot";
+
     //Simple switch statement for lookup.
     if (type == NodeType::FILE){
-        return "cObjectFile";
+        return FILE_STR;
     } else if (type == NodeType::FUNCTION){
-        return "cFunction";
+        return FUNCTION_STR;
     } else if (type == NodeType::OBJECT){
-        return "cObject";
+        return OBJECT_STR;
     } else if (type == NodeType::SUBSYSTEM){
-        return "cSubSystem";
+        return SUBSYSTEM_STR;
     }
 
     //If the lookup fails, puts item at top level.
     //This shouldn't happen.
-    return "cRoot";
+    return ROOT_STR;
 }
 
 /**
- * Gets the node ID.
+ * Gets the letter that starts the short IDs of a node type.
+ * @param type The node type.
+ * @return The prefix letter.
+ */
+char BFXNode::getTypePrefix(NodeType type){
+    if (type == NodeType::FILE){
+        return 'o';
+    } else if (type == NodeType::FUNCTION){
+        return 'f';
+    } else if (type == NodeType::OBJECT){
+        return 'v';
+    } else if (type == NodeType::SUBSYSTEM){
+        return 's';
+    }
+
+    return 'r';
+}
+
+/**
+ * Gets the node type named by a TA class.
+ * @param str The class name.
+ * @param type The node type.
+ * @return Whether the class names a node type.
+ */
+bool BFXNode::getTypeFromString(string_view str, NodeType& type){
+    static const NodeType TYPES[] = {NodeType::FILE, NodeType::OBJECT, NodeType::FUNCTION, NodeType::SUBSYSTEM};
+
+    for (NodeType curr : TYPES){
+        if (str == getTypeString(curr)){
+            type = curr;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Gets the node ID. The path part refers to the graph's
+ * path trie.
  * @return The node ID.
  */
-string BFXNode::getID() {
+const CompactID& BFXNode::getID() const {
     return ID;
 }
 
@@ -82,7 +128,7 @@ string BFXNode::getID() {
  * Gets the type of node.
  * @return The type of node.
  */
-BFXNode::NodeType BFXNode::getType(){
+BFXNode::NodeType BFXNode::getType() const {
     return type;
 }
 
@@ -90,7 +136,7 @@ BFXNode::NodeType BFXNode::getType(){
  * Gets the name (unmangled).
  * @return The unmangled name.
  */
-string BFXNode::getName(){
+string_view BFXNode::getName() const {
     return name;
 }
 
@@ -98,7 +144,7 @@ string BFXNode::getName(){
  * Gets all mangled names that translate over.
  * @return All mangled names.
  */
-vector<string> BFXNode::getMangledNames() {
+const pmr::vector<pmr::string>& BFXNode::getMangledNames() const {
     return mangledNames;
 }
 
@@ -106,8 +152,8 @@ vector<string> BFXNode::getMangledNames() {
  * Sets the node ID.
  * @param nID The new node ID.
  */
-void BFXNode::setID(string nID){
-    ID = nID;
+void BFXNode::setID(CompactID nID){
+    ID = move(nID);
 }
 
 /**
@@ -122,16 +168,16 @@ void BFXNode::setType(NodeType nType){
  * Sets the name.
  * @param nName The new node unmangled name.
  */
-void BFXNode::setName(std::string nName){
-    name = nName;
+void BFXNode::setName(string_view nName){
+    name.assign(nName.data(), nName.size());
 }
 
 /**
  * Adds a new mangled name to the mangle list.
  * @param nMangle The name to add.
  */
-void BFXNode::addMangledName(string nMangle) {
-    mangledNames.push_back(nMangle);
+void BFXNode::addMangledName(string_view nMangle) {
+    mangledNames.emplace_back(nMangle);
 }
 
 /**
@@ -139,12 +185,75 @@ void BFXNode::addMangledName(string nMangle) {
  * @param name The name to look for.
  * @return Boolean indicating whether it was found.
  */
-bool BFXNode::doesMangledNameExist(std::string name){
+bool BFXNode::doesMangledNameExist(string_view name) const {
     //Iterate through our vector and look.
-    for (int i = 0; i < mangledNames.size(); i++){
-        if (mangledNames.at(i).compare(name) == 0)
-            return true;
+    for (const pmr::string& curr : mangledNames){
+        if (curr == name) return true;
     }
 
     return false;
+}
+
+/**
+ * Gets the edges leaving this node.
+ * @return The outgoing edges.
+ */
+const pmr::vector<BFXEdge*>& BFXNode::getOutEdges() const {
+    return outEdges;
+}
+
+/**
+ * Gets the edges entering this node.
+ * @return The incoming edges.
+ */
+const pmr::vector<BFXEdge*>& BFXNode::getInEdges() const {
+    return inEdges;
+}
+
+/**
+ * Records an edge leaving this node.
+ * @param edge The outgoing edge.
+ */
+void BFXNode::addOutEdge(BFXEdge* edge){
+    outEdges.push_back(edge);
+}
+
+/**
+ * Records an edge entering this node.
+ * @param edge The incoming edge.
+ */
+void BFXNode::addInEdge(BFXEdge* edge){
+    inEdges.push_back(edge);
+}
+
+/**
+ * Forgets an edge leaving this node.
+ * @param edge The outgoing edge.
+ */
+void BFXNode::removeOutEdge(BFXEdge* edge){
+    removeEdge(outEdges, edge);
+}
+
+/**
+ * Forgets an edge entering this node.
+ * @param edge The incoming edge.
+ */
+void BFXNode::removeInEdge(BFXEdge* edge){
+    removeEdge(inEdges, edge);
+}
+
+/**
+ * Removes an edge from an adjacency list by swapping it
+ * with the last entry. Costs O(degree).
+ * @param edges The adjacency list.
+ * @param edge The edge to remove.
+ */
+void BFXNode::removeEdge(pmr::vector<BFXEdge*>& edges, BFXEdge* edge){
+    for (size_t i = 0; i < edges.size(); i++){
+        if (edges[i] != edge) continue;
+
+        edges[i] = edges.back();
+        edges.pop_back();
+        return;
+    }
 }
\ No newline at end of file
@@ -27,8 +27,13 @@
 #ifndef BFX64_NODE_H
 #define BFX64_NODE_H
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "PathTrie.h"
+
+class BFXEdge;
 
 class BFXNode {
 public:
@@ -36,31 +41,47 @@ public:
     enum NodeType { FILE, OBJECT, FUNCTION, SUBSYSTEM };
 
     /** Constructor / Destructor */
-    BFXNode(std::string ID, NodeType type, std::string name, std::vector<std::string> mangledNames);
+    BFXNode(CompactID ID, NodeType type, std::string_view name, const std::vector<std::string>& mangledNames,
+            std::pmr::memory_resource* memory = std::pmr::new_delete_resource());
     ~BFXNode();
 
     /** Lookup Method */
-    static std::string getTypeString(NodeType type);
+    static const std::string& getTypeString(NodeType type);
+    static char getTypePrefix(NodeType type);
+    static bool getTypeFromString(std::string_view str, NodeType& type);
 
     /** Getters and Setters */
-    std::string getID();
-    BFXNode::NodeType getType();
-    std::string getName();
-    std::vector<std::string> getMangledNames();
-    void setID(std::string nID);
+    const CompactID& getID() const;
+    BFXNode::NodeType getType() const;
+    std::string_view getName() const;
+    const std::pmr::vector<std::pmr::string>& getMangledNames() const;
+    void setID(CompactID nID);
     void setType(NodeType nType);
-    void setName(std::string nName);
-    void addMangledName(std::string nMangle);
+    void setName(std::string_view nName);
+    void addMangledName(std::string_view nMangle);
 
     /** Lookup Methods */
-    bool doesMangledNameExist(std::string name);
+    bool doesMangledNameExist(std::string_view name) const;
+
+    /** Adjacency Methods */
+    const std::pmr::vector<BFXEdge*>& getOutEdges() const;
+    const std::pmr::vector<BFXEdge*>& getInEdges() const;
+    void addOutEdge(BFXEdge* edge);
+    void addInEdge(BFXEdge* edge);
+    void removeOutEdge(BFXEdge* edge);
+    void removeInEdge(BFXEdge* edge);
 
 private:
-    /** Private Variables */
-    std::string ID;
+    /** Private Variables (Allocated From the Graph's Storage) */
+    CompactID ID;
     NodeType type;
-    std::string name;
-    std::vector<std::string> mangledNames;
+    std::pmr::string name;
+    std::pmr::vector<std::pmr::string> mangledNames;
+    std::pmr::vector<BFXEdge*> outEdges;
+    std::pmr::vector<BFXEdge*> inEdges;
+
+    /** Helper Methods */
+    static void removeEdge(std::pmr::vector<BFXEdge*>& edges, BFXEdge* edge);
 };
 
 
@@ -0,0 +1,176 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BloomFilter.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Blocked Bloom filter used for existence checks in low memory
+// mode. Every key sets a handful of bits inside one cache-line
+// sized block, so a lookup touches a single line of memory. The
+// filter grows by adding larger stages as it fills, which keeps
+// the false positive rate steady without knowing the final size.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <functional>
+#include "BloomFilter.h"
+
+using namespace std;
+
+const size_t BloomFilter::DEFAULT_EXPECTED = 1 << 16;
+const size_t BloomFilter::BITS_PER_KEY = 12;
+const int BloomFilter::NUM_PROBES = 8;
+
+/**
+ * Creates an empty filter.
+ * @param expected The number of keys the first stage holds.
+ */
+BloomFilter::BloomFilter(size_t expected){
+    initialCapacity = (expected == 0) ? DEFAULT_EXPECTED : expected;
+    numKeys = 0;
+}
+
+/**
+ * Default destructor.
+ */
+BloomFilter::~BloomFilter(){ }
+
+/**
+ * Sizes the first stage for an expected number of keys. Only
+ * has an effect before the first insert.
+ * @param expected The expected number of keys.
+ */
+void BloomFilter::reserve(size_t expected){
+    if (stages.size() != 0 || expected == 0) return;
+    initialCapacity = expected;
+}
+
+/**
+ * Adds a key to the filter.
+ * @param key The key to add.
+ */
+void BloomFilter::insert(string_view key){
+    //Open a new, larger stage once the current one is full.
+    if (stages.size() == 0){
+        addStage(initialCapacity);
+    } else if (stages.back().count >= stages.back().capacity){
+        addStage(stages.back().capacity * 2);
+    }
+
+    Stage& stage = stages.back();
+    uint64_t hash = hashKey(key);
+    Block& block = stage.blocks[(hash >> 32) % stage.blocks.size()];
+
+    //Each probe picks one of the 512 bits in the block.
+    uint32_t probe = (uint32_t) hash;
+    uint32_t step = (uint32_t) ((hash * 0x9e3779b97f4a7c15ULL) >> 32) | 1;
+    for (int i = 0; i < NUM_PROBES; i++){
+        uint32_t bit = probe & 511;
+        block.words[bit >> 6] |= (uint64_t) 1 << (bit & 63);
+        probe += step;
+    }
+
+    stage.count++;
+    numKeys++;
+}
+
+/**
+ * Checks whether a key may be in the filter. A false
+ * answer is exact; a true answer may be a false positive.
+ * @param key The key to look for.
+ * @return Whether the key may have been added.
+ */
+bool BloomFilter::mayContain(string_view key) const {
+    uint64_t hash = hashKey(key);
+    for (auto const& stage : stages){
+        if (testStage(stage, hash)) return true;
+    }
+    return false;
+}
+
+/**
+ * Removes every key and releases all stages.
+ */
+void BloomFilter::clear(){
+    stages.clear();
+    numKeys = 0;
+}
+
+/**
+ * Gets the number of keys added.
+ * @return The number of keys.
+ */
+size_t BloomFilter::size() const {
+    return numKeys;
+}
+
+/**
+ * Gets the number of bytes used by the bit arrays.
+ * @return The memory used.
+ */
+size_t BloomFilter::getMemoryBytes() const {
+    size_t total = 0;
+    for (auto const& stage : stages) total += stage.blocks.size() * sizeof(Block);
+    return total;
+}
+
+/**
+ * Adds a new stage to the filter.
+ * @param capacity The number of keys the stage holds.
+ */
+void BloomFilter::addStage(size_t capacity){
+    Stage stage;
+    size_t numBlocks = (capacity * BITS_PER_KEY + 511) / 512;
+    stage.blocks.assign(numBlocks == 0 ? 1 : numBlocks, Block());
+    stage.capacity = capacity;
+    stage.count = 0;
+    stages.push_back(stage);
+}
+
+/**
+ * Hashes a key and mixes the bits.
+ * @param key The key to hash.
+ * @return The 64-bit hash.
+ */
+uint64_t BloomFilter::hashKey(string_view key){
+    uint64_t h = (uint64_t) std::hash<string_view>()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Checks a hash against a single stage.
+ * @param stage The stage to check.
+ * @param hash The key hash.
+ * @return Whether all probe bits are set.
+ */
+bool BloomFilter::testStage(const Stage& stage, uint64_t hash){
+    const Block& block = stage.blocks[(hash >> 32) % stage.blocks.size()];
+
+    uint32_t probe = (uint32_t) hash;
+    uint32_t step = (uint32_t) ((hash * 0x9e3779b97f4a7c15ULL) >> 32) | 1;
+    for (int i = 0; i < NUM_PROBES; i++){
+        uint32_t bit = probe & 511;
+        if ((block.words[bit >> 6] & ((uint64_t) 1 << (bit & 63))) == 0) return false;
+        probe += step;
+    }
+    return true;
+}
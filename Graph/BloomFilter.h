@@ -0,0 +1,85 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BloomFilter.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Blocked Bloom filter used for existence checks in low memory
+// mode. Every key sets a handful of bits inside one cache-line
+// sized block, so a lookup touches a single line of memory. The
+// filter grows by adding larger stages as it fills, which keeps
+// the false positive rate steady without knowing the final size.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_BLOOMFILTER_H
+#define BFX64_BLOOMFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class BloomFilter {
+public:
+    /** Constructor / Destructor */
+    BloomFilter(size_t expected = DEFAULT_EXPECTED);
+    ~BloomFilter();
+
+    /** Filter Operations */
+    void reserve(size_t expected);
+    void insert(std::string_view key);
+    bool mayContain(std::string_view key) const;
+    void clear();
+
+    /** Getters */
+    size_t size() const;
+    size_t getMemoryBytes() const;
+
+    static const size_t DEFAULT_EXPECTED;
+
+private:
+    /** Filter Tuning */
+    static const size_t BITS_PER_KEY;
+    static const int NUM_PROBES;
+    static const size_t BLOCK_WORDS = 8;
+
+    /** One Cache Line of Bits */
+    struct Block {
+        uint64_t words[BLOCK_WORDS];
+    };
+
+    /** One Fixed Size Stage */
+    struct Stage {
+        std::vector<Block> blocks;
+        size_t capacity;
+        size_t count;
+    };
+
+    /** Private Variables */
+    std::vector<Stage> stages;
+    size_t initialCapacity;
+    size_t numKeys;
+
+    /** Helper Methods */
+    void addStage(size_t capacity);
+    static uint64_t hashKey(std::string_view key);
+    static bool testStage(const Stage& stage, uint64_t hash);
+};
+
+#endif //BFX64_BLOOMFILTER_H
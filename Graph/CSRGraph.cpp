@@ -0,0 +1,649 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CSRGraph.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Immutable compressed-sparse-row layout of a finished graph.
+// Nodes are stored in a flat table backed by a single string pool
+// and every edge type keeps sorted forward and reverse adjacency
+// arrays. Once a TAGraph is finalized, output and traversal are
+// sequential scans over these arrays.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CSRGraph.h"
+
+using namespace std;
+
+/** Snapshot Identification */
+static const char SNAPSHOT_MAGIC[8] = {'B', 'F', 'X', 'G', 'R', 'A', 'P', 'H'};
+static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+static const uint64_t SNAPSHOT_ALIGN = 8;
+
+/**
+ * Creates an empty CSR graph. Nodes and edges are
+ * added and then the graph is built once. Path 0 is
+ * the empty path.
+ * @param memory Where the tables and adjacency arrays are allocated.
+ */
+CSRGraph::CSRGraph(pmr::memory_resource* memory) : strings(memory), paths(memory), nodes(memory) {
+    for (int i = 0; i < EDGE_TYPES; i++) adjacency.emplace_back(memory);
+    built = false;
+    mapping = nullptr;
+    mappingBytes = 0;
+    paths.push_back(PathRecord{0, 0});
+    refreshViews();
+}
+
+/**
+ * Destructor. Unmaps the snapshot if the graph was loaded.
+ */
+CSRGraph::~CSRGraph(){
+    if (mapping != nullptr) munmap(mapping, mappingBytes);
+}
+
+/**
+ * Reserves space for the node table and edge staging.
+ * @param numNodes The expected number of nodes.
+ * @param numEdges The expected number of edges.
+ */
+void CSRGraph::reserve(size_t numNodes, size_t numEdges){
+    nodes.reserve(numNodes);
+    adjacency[BFXEdge::CONTAINS].staged.reserve(numNodes);
+    adjacency[BFXEdge::LINK].staged.reserve(numEdges);
+}
+
+/**
+ * Adds an ID path to the path table. Nodes sharing a path
+ * refer to the same entry.
+ * @param path The path.
+ * @return The index of the new path.
+ */
+uint32_t CSRGraph::addPath(string_view path){
+    PathRecord record;
+    record.offset = addString(path);
+    record.length = path.size();
+
+    paths.push_back(record);
+    return (uint32_t) (paths.size() - 1);
+}
+
+/**
+ * Adds a node to the node table. Nodes must be added in
+ * ascending ID order for lookups to work. The ID is the
+ * node's path followed by its suffix.
+ * @param path The index of the ID path.
+ * @param suffix The rest of the ID.
+ * @param type The type of node.
+ * @param name The unmangled name of the node.
+ * @return The index of the new node.
+ */
+uint32_t CSRGraph::addNode(uint32_t path, string_view suffix, BFXNode::NodeType type, string_view name){
+    NodeRecord record;
+    record.suffixOffset = addString(suffix);
+    record.suffixLength = (uint32_t) suffix.size();
+    record.nameOffset = addString(name);
+    record.nameLength = (uint32_t) name.size();
+    record.type = (uint32_t) type;
+    record.path = path;
+
+    nodes.push_back(record);
+    return (uint32_t) (nodes.size() - 1);
+}
+
+/**
+ * Stages an edge between two node indices. Edges are laid
+ * out into the CSR arrays when the graph is built.
+ * @param src The source node index.
+ * @param dst The destination node index.
+ * @param type The type of edge.
+ * @param count The number of times the edge was seen.
+ */
+void CSRGraph::addEdge(uint32_t src, uint32_t dst, BFXEdge::EdgeType type, uint32_t count){
+    adjacency[type].staged.push_back(StagedEdge{src, dst, count});
+}
+
+/**
+ * Lays out the staged edges into sorted forward and
+ * reverse arrays for each edge type.
+ */
+void CSRGraph::build(){
+    for (int i = 0; i < EDGE_TYPES; i++){
+        Adjacency& adj = adjacency[i];
+        buildRows(nodes.size(), adj.staged, false, adj.fwdOffsets, adj.fwdTargets, &adj.fwdCounts);
+        buildRows(nodes.size(), adj.staged, true, adj.revOffsets, adj.revSources, nullptr);
+
+        //Release the staging area.
+        pmr::vector<StagedEdge>(adj.staged.get_allocator()).swap(adj.staged);
+    }
+
+    strings.shrink_to_fit();
+    paths.shrink_to_fit();
+    nodes.shrink_to_fit();
+    built = true;
+    refreshViews();
+}
+
+/**
+ * Gets the number of nodes.
+ * @return The number of nodes.
+ */
+size_t CSRGraph::getNumNodes() const {
+    return (size_t) numNodes;
+}
+
+/**
+ * Gets the ID of a node.
+ * @param node The node index.
+ * @return The node ID.
+ */
+string CSRGraph::getID(uint32_t node) const {
+    string ID;
+    appendID(ID, node);
+    return ID;
+}
+
+/**
+ * Gets the unmangled name of a node.
+ * @param node The node index.
+ * @return The node name.
+ */
+string CSRGraph::getName(uint32_t node) const {
+    const NodeRecord& record = nodeData[node];
+    return string(stringData + record.nameOffset, record.nameLength);
+}
+
+/**
+ * Gets the type of a node.
+ * @param node The node index.
+ * @return The node type.
+ */
+BFXNode::NodeType CSRGraph::getType(uint32_t node) const {
+    return (BFXNode::NodeType) nodeData[node].type;
+}
+
+/**
+ * Appends the ID of a node to a string without a copy.
+ * @param out The string to append to.
+ * @param node The node index.
+ */
+void CSRGraph::appendID(string& out, uint32_t node) const {
+    const NodeRecord& record = nodeData[node];
+    const PathRecord& path = pathData[record.path];
+    out.append(stringData + path.offset, path.length);
+    out.append(stringData + record.suffixOffset, record.suffixLength);
+}
+
+/**
+ * Appends the name of a node to a string without a copy.
+ * @param out The string to append to.
+ * @param node The node index.
+ */
+void CSRGraph::appendName(string& out, uint32_t node) const {
+    const NodeRecord& record = nodeData[node];
+    out.append(stringData + record.nameOffset, record.nameLength);
+}
+
+/**
+ * Checks whether a node has a non-empty name.
+ * @param node The node index.
+ * @return Boolean indicating whether a name exists.
+ */
+bool CSRGraph::hasName(uint32_t node) const {
+    return nodeData[node].nameLength != 0;
+}
+
+/**
+ * Gets the path table entry holding the path part of a node ID.
+ * @param node The node index.
+ * @return The path index.
+ */
+uint32_t CSRGraph::getPath(uint32_t node) const {
+    return nodeData[node].path;
+}
+
+/**
+ * Gets the part of a node ID after its path.
+ * @param node The node index.
+ * @return The suffix, empty for file and subsystem nodes.
+ */
+string_view CSRGraph::getSuffix(uint32_t node) const {
+    const NodeRecord& record = nodeData[node];
+    return string_view(stringData + record.suffixOffset, record.suffixLength);
+}
+
+/**
+ * Gets the number of distinct ID paths.
+ * @return The number of paths.
+ */
+size_t CSRGraph::getNumPaths() const {
+    return (size_t) numPaths;
+}
+
+/**
+ * Appends a path from the path table to a string.
+ * @param out The string to append to.
+ * @param path The path index.
+ */
+void CSRGraph::appendPath(string& out, uint32_t path) const {
+    const PathRecord& record = pathData[path];
+    out.append(stringData + record.offset, record.length);
+}
+
+/**
+ * Gets the number of edges of a type.
+ * @param type The edge type.
+ * @return The number of edges.
+ */
+size_t CSRGraph::getNumEdges(BFXEdge::EdgeType type) const {
+    return (size_t) views[type].numEdges;
+}
+
+/**
+ * Gets the sorted destinations of all edges leaving a node.
+ * @param node The source node index.
+ * @param type The edge type.
+ * @return The range of destination indices.
+ */
+CSRGraph::Range CSRGraph::getOutEdges(uint32_t node, BFXEdge::EdgeType type) const {
+    const AdjacencyView& adj = views[type];
+    Range range;
+    range.first = adj.fwdTargets + adj.fwdOffsets[node];
+    range.last = adj.fwdTargets + adj.fwdOffsets[node + 1];
+    return range;
+}
+
+/**
+ * Gets the counts of all edges leaving a node, in the same
+ * order as getOutEdges.
+ * @param node The source node index.
+ * @param type The edge type.
+ * @return The range of edge counts.
+ */
+CSRGraph::Range CSRGraph::getOutCounts(uint32_t node, BFXEdge::EdgeType type) const {
+    const AdjacencyView& adj = views[type];
+    Range range;
+    range.first = adj.fwdCounts + adj.fwdOffsets[node];
+    range.last = adj.fwdCounts + adj.fwdOffsets[node + 1];
+    return range;
+}
+
+/**
+ * Gets the sorted sources of all edges entering a node.
+ * @param node The destination node index.
+ * @param type The edge type.
+ * @return The range of source indices.
+ */
+CSRGraph::Range CSRGraph::getInEdges(uint32_t node, BFXEdge::EdgeType type) const {
+    const AdjacencyView& adj = views[type];
+    Range range;
+    range.first = adj.revSources + adj.revOffsets[node];
+    range.last = adj.revSources + adj.revOffsets[node + 1];
+    return range;
+}
+
+/**
+ * Finds a node by ID using a binary search over the node table.
+ * @param ID The ID to look for.
+ * @param node The index of the node, if found.
+ * @return Boolean indicating whether the node was found.
+ */
+bool CSRGraph::findNode(string_view ID, uint32_t& node) const {
+    size_t low = 0;
+    size_t high = (size_t) numNodes;
+
+    //Binary search on the sorted node table.
+    while (low < high){
+        size_t mid = low + (high - low) / 2;
+        int cmp = compareID((uint32_t) mid, ID);
+        if (cmp == 0){
+            node = (uint32_t) mid;
+            return true;
+        } else if (cmp < 0){
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Checks whether an edge exists between two nodes.
+ * @param src The source node index.
+ * @param dst The destination node index.
+ * @param type The edge type.
+ * @return Boolean indicating whether the edge was found.
+ */
+bool CSRGraph::doesEdgeExist(uint32_t src, uint32_t dst, BFXEdge::EdgeType type) const {
+    if (!built) return false;
+
+    Range row = getOutEdges(src, type);
+    return binary_search(row.begin(), row.end(), dst);
+}
+
+/**
+ * Writes the built graph as a binary snapshot. The file holds a
+ * header, the string pool, the path and node tables and the CSR arrays of
+ * each edge type. Sections are referenced by file offset and
+ * aligned so the loader can map them in place.
+ * @param path The snapshot file to write.
+ * @return Boolean indicating whether the snapshot was written.
+ */
+bool CSRGraph::save(const string& path) const {
+    if (!built) return false;
+
+    //Lay out the sections after the header.
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.edgeTypes = EDGE_TYPES;
+    header.recordSize = sizeof(NodeRecord);
+    header.numNodes = numNodes;
+    header.numPaths = numPaths;
+
+    uint64_t offset = sizeof(SnapshotHeader);
+    auto place = [&offset](uint64_t bytes){
+        uint64_t start = (offset + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+        offset = start + bytes;
+        return start;
+    };
+    header.stringBytes = strings.size();
+    header.stringOffset = place(header.stringBytes);
+    header.pathOffset = place(numPaths * sizeof(PathRecord));
+    header.nodeOffset = place(numNodes * sizeof(NodeRecord));
+    for (int i = 0; i < EDGE_TYPES; i++){
+        SnapshotSection& section = header.sections[i];
+        section.numEdges = views[i].numEdges;
+        section.fwdOffsets = place((numNodes + 1) * sizeof(uint64_t));
+        section.fwdTargets = place(section.numEdges * sizeof(uint32_t));
+        section.fwdCounts = place(section.numEdges * sizeof(uint32_t));
+        section.revOffsets = place((numNodes + 1) * sizeof(uint64_t));
+        section.revSources = place(section.numEdges * sizeof(uint32_t));
+    }
+    header.fileBytes = offset;
+
+    ofstream out(path.c_str(), ios::binary | ios::trunc);
+    if (!out.is_open()) return false;
+
+    //Writes a section, padding up to its offset first.
+    uint64_t written = 0;
+    auto write = [&out, &written](uint64_t at, const void* data, uint64_t bytes){
+        static const char zeros[SNAPSHOT_ALIGN] = {0};
+        if (at > written) out.write(zeros, (streamsize) (at - written));
+        if (bytes > 0) out.write((const char*) data, (streamsize) bytes);
+        written = at + bytes;
+    };
+
+    write(0, &header, sizeof(header));
+    write(header.stringOffset, stringData, header.stringBytes);
+    write(header.pathOffset, pathData, numPaths * sizeof(PathRecord));
+
+    //Records are copied so struct padding is written as zeros.
+    write(header.nodeOffset, nullptr, 0);
+    for (uint64_t i = 0; i < numNodes; i++){
+        NodeRecord record;
+        memset(&record, 0, sizeof(record));
+        record.suffixOffset = nodeData[i].suffixOffset;
+        record.nameOffset = nodeData[i].nameOffset;
+        record.suffixLength = nodeData[i].suffixLength;
+        record.nameLength = nodeData[i].nameLength;
+        record.type = nodeData[i].type;
+        record.path = nodeData[i].path;
+        out.write((const char*) &record, sizeof(record));
+    }
+    written += numNodes * sizeof(NodeRecord);
+
+    for (int i = 0; i < EDGE_TYPES; i++){
+        const SnapshotSection& section = header.sections[i];
+        write(section.fwdOffsets, views[i].fwdOffsets, (numNodes + 1) * sizeof(uint64_t));
+        write(section.fwdTargets, views[i].fwdTargets, section.numEdges * sizeof(uint32_t));
+        write(section.fwdCounts, views[i].fwdCounts, section.numEdges * sizeof(uint32_t));
+        write(section.revOffsets, views[i].revOffsets, (numNodes + 1) * sizeof(uint64_t));
+        write(section.revSources, views[i].revSources, section.numEdges * sizeof(uint32_t));
+    }
+
+    out.close();
+    return !out.fail();
+}
+
+/**
+ * Loads a binary snapshot by mapping it into memory. The arrays
+ * are served straight from the mapping; nothing is copied. The
+ * header, the section bounds and every record are checked before
+ * use, so a corrupt file is rejected instead of read out of bounds.
+ * @param path The snapshot file to load.
+ * @return The loaded graph (or nullptr if the file is invalid).
+ */
+CSRGraph* CSRGraph::load(const string& path){
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (uint64_t) info.st_size < sizeof(SnapshotHeader)){
+        close(fd);
+        return nullptr;
+    }
+
+    size_t bytes = (size_t) info.st_size;
+    void* base = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return nullptr;
+
+    //Check the header matches this build.
+    const char* data = (const char*) base;
+    const SnapshotHeader* header = (const SnapshotHeader*) data;
+    bool valid = memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+            header->version == SNAPSHOT_VERSION && header->byteOrder == SNAPSHOT_BYTE_ORDER &&
+            header->edgeTypes == (uint32_t) EDGE_TYPES && header->recordSize == sizeof(NodeRecord) &&
+            header->fileBytes == bytes && header->numNodes < UINT32_MAX &&
+            header->numPaths > 0 && header->numPaths < UINT32_MAX;
+
+    //Every section must sit inside the file.
+    auto inside = [bytes](uint64_t at, uint64_t count, uint64_t size){
+        return at % SNAPSHOT_ALIGN == 0 && at <= bytes && count <= (bytes - at) / size;
+    };
+    uint64_t numNodes = header->numNodes;
+    valid = valid && inside(header->stringOffset, header->stringBytes, 1) &&
+            inside(header->pathOffset, header->numPaths, sizeof(PathRecord)) &&
+            inside(header->nodeOffset, numNodes, sizeof(NodeRecord));
+    for (int i = 0; valid && i < EDGE_TYPES; i++){
+        const SnapshotSection& section = header->sections[i];
+        valid = inside(section.fwdOffsets, numNodes + 1, sizeof(uint64_t)) &&
+                inside(section.fwdTargets, section.numEdges, sizeof(uint32_t)) &&
+                inside(section.fwdCounts, section.numEdges, sizeof(uint32_t)) &&
+                inside(section.revOffsets, numNodes + 1, sizeof(uint64_t)) &&
+                inside(section.revSources, section.numEdges, sizeof(uint32_t));
+
+        //The last row offset has to close the neighbour array.
+        valid = valid && ((const uint64_t*) (data + section.fwdOffsets))[numNodes] == section.numEdges &&
+                ((const uint64_t*) (data + section.revOffsets))[numNodes] == section.numEdges;
+    }
+    if (!valid){
+        munmap(base, bytes);
+        return nullptr;
+    }
+
+    //Point the accessors at the mapping.
+    CSRGraph* graph = new CSRGraph();
+    graph->mapping = base;
+    graph->mappingBytes = bytes;
+    graph->built = true;
+    graph->stringData = data + header->stringOffset;
+    graph->pathData = (const PathRecord*) (data + header->pathOffset);
+    graph->nodeData = (const NodeRecord*) (data + header->nodeOffset);
+    graph->numNodes = numNodes;
+    graph->numPaths = header->numPaths;
+    for (int i = 0; i < EDGE_TYPES; i++){
+        const SnapshotSection& section = header->sections[i];
+        AdjacencyView& view = graph->views[i];
+        view.fwdOffsets = (const uint64_t*) (data + section.fwdOffsets);
+        view.fwdTargets = (const uint32_t*) (data + section.fwdTargets);
+        view.fwdCounts = (const uint32_t*) (data + section.fwdCounts);
+        view.revOffsets = (const uint64_t*) (data + section.revOffsets);
+        view.revSources = (const uint32_t*) (data + section.revSources);
+        view.numEdges = section.numEdges;
+    }
+
+    if (!graph->checkRecords(header->stringBytes)){
+        delete graph;
+        return nullptr;
+    }
+    return graph;
+}
+
+/**
+ * Checks that every record of a mapped snapshot points inside
+ * the snapshot, in one pass over each array.
+ * @param stringBytes The size of the string pool.
+ * @return Whether every string range, path, row offset and neighbour is in range.
+ */
+bool CSRGraph::checkRecords(uint64_t stringBytes) const {
+    auto inPool = [stringBytes](uint64_t offset, uint64_t length){
+        return offset <= stringBytes && length <= stringBytes - offset;
+    };
+
+    for (uint64_t i = 0; i < numPaths; i++){
+        if (!inPool(pathData[i].offset, pathData[i].length)) return false;
+    }
+    for (uint64_t i = 0; i < numNodes; i++){
+        const NodeRecord& record = nodeData[i];
+        if (!inPool(record.suffixOffset, record.suffixLength) || !inPool(record.nameOffset, record.nameLength) ||
+            record.path >= numPaths || record.type > BFXNode::SUBSYSTEM) return false;
+    }
+
+    //Rows must run in order and every neighbour must be a node.
+    for (int i = 0; i < EDGE_TYPES; i++){
+        const AdjacencyView& view = views[i];
+        const uint64_t* offsets[2] = {view.fwdOffsets, view.revOffsets};
+        const uint32_t* neighbours[2] = {view.fwdTargets, view.revSources};
+        for (int j = 0; j < 2; j++){
+            if (offsets[j][0] != 0) return false;
+            for (uint64_t k = 0; k < numNodes; k++){
+                if (offsets[j][k] > offsets[j][k + 1]) return false;
+            }
+            for (uint64_t k = 0; k < view.numEdges; k++){
+                if (neighbours[j][k] >= numNodes) return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Points the accessors at the arrays owned by this graph.
+ */
+void CSRGraph::refreshViews(){
+    stringData = strings.data();
+    pathData = paths.data();
+    nodeData = nodes.data();
+    numNodes = nodes.size();
+    numPaths = paths.size();
+
+    //An empty graph still has one row offset per type.
+    static const uint64_t emptyOffsets[1] = {0};
+    for (int i = 0; i < EDGE_TYPES; i++){
+        const Adjacency& adj = adjacency[i];
+        AdjacencyView& view = views[i];
+        view.fwdOffsets = (adj.fwdOffsets.empty()) ? emptyOffsets : adj.fwdOffsets.data();
+        view.fwdTargets = adj.fwdTargets.data();
+        view.fwdCounts = adj.fwdCounts.data();
+        view.revOffsets = (adj.revOffsets.empty()) ? emptyOffsets : adj.revOffsets.data();
+        view.revSources = adj.revSources.data();
+        view.numEdges = adj.fwdTargets.size();
+    }
+}
+
+/**
+ * Adds a string to the string pool.
+ * @param str The string to add.
+ * @return The offset of the string in the pool.
+ */
+uint64_t CSRGraph::addString(string_view str){
+    uint64_t offset = strings.size();
+    strings.insert(strings.end(), str.begin(), str.end());
+    return offset;
+}
+
+/**
+ * Compares the ID of a node against a string.
+ * @param node The node index.
+ * @param ID The ID to compare to.
+ * @return Negative, zero or positive like strcmp.
+ */
+int CSRGraph::compareID(uint32_t node, string_view ID) const {
+    const NodeRecord& record = nodeData[node];
+    const PathRecord& path = pathData[record.path];
+    return PathTrie::compareJoined(string_view(stringData + path.offset, (size_t) path.length),
+                                   string_view(stringData + record.suffixOffset, record.suffixLength),
+                                   ID, string_view());
+}
+
+/**
+ * Lays out a list of edges into row offsets and sorted
+ * neighbour arrays using a counting sort on the row.
+ * @param numNodes The number of nodes.
+ * @param edges The staged edges.
+ * @param reverse Whether rows are keyed by destination.
+ * @param offsets The row offsets to fill.
+ * @param targets The neighbour array to fill.
+ * @param counts The edge counts to fill alongside the neighbours (or nullptr).
+ */
+void CSRGraph::buildRows(size_t numNodes, const pmr::vector<StagedEdge>& edges, bool reverse,
+                         pmr::vector<uint64_t>& offsets, pmr::vector<uint32_t>& targets,
+                         pmr::vector<uint32_t>* counts){
+    offsets.assign(numNodes + 1, 0);
+
+    //Count the degree of each row.
+    for (auto const& edge : edges){
+        uint32_t row = (reverse) ? edge.dst : edge.src;
+        offsets[row + 1]++;
+    }
+    for (size_t i = 0; i < numNodes; i++) offsets[i + 1] += offsets[i];
+
+    //Scatter the neighbours into their rows.
+    pmr::vector<pair<uint32_t, uint32_t>> cells(edges.size(), offsets.get_allocator());
+    pmr::vector<uint64_t> cursor(offsets.begin(), offsets.end() - 1, offsets.get_allocator());
+    for (auto const& edge : edges){
+        uint32_t row = (reverse) ? edge.dst : edge.src;
+        uint32_t col = (reverse) ? edge.src : edge.dst;
+        cells[cursor[row]++] = make_pair(col, edge.count);
+    }
+
+    //Sort each row so lookups and output are ordered.
+    for (size_t i = 0; i < numNodes; i++){
+        sort(cells.begin() + offsets[i], cells.begin() + offsets[i + 1]);
+    }
+
+    targets.resize(cells.size());
+    if (counts != nullptr) counts->resize(cells.size());
+    for (size_t i = 0; i < cells.size(); i++){
+        targets[i] = cells[i].first;
+        if (counts != nullptr) (*counts)[i] = cells[i].second;
+    }
+}
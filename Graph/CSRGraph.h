@@ -0,0 +1,201 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CSRGraph.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Immutable compressed-sparse-row layout of a finished graph.
+// Nodes are stored in a flat table backed by a single string pool
+// and every edge type keeps sorted forward and reverse adjacency
+// arrays. Once a TAGraph is finalized, output and traversal are
+// sequential scans over these arrays.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_CSRGRAPH_H
+#define BFX64_CSRGRAPH_H
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "BFXNode.h"
+#include "BFXEdge.h"
+#include "PathTrie.h"
+
+class CSRGraph {
+public:
+    /** Number of Edge Types */
+    static const int EDGE_TYPES = BFXEdge::LINK + 1;
+
+    /** Node Record (Offsets Into the String Pool) */
+    struct NodeRecord {
+        uint64_t suffixOffset;
+        uint64_t nameOffset;
+        uint32_t suffixLength;
+        uint32_t nameLength;
+        uint32_t type;
+        uint32_t path;
+    };
+
+    /** Path Record (Each Distinct ID Path Is Stored Once) */
+    struct PathRecord {
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    /** Range of Neighbour Indices */
+    struct Range {
+        const uint32_t* first;
+        const uint32_t* last;
+
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return (size_t) (last - first); }
+    };
+
+    /** Snapshot Format Version */
+    static const uint32_t SNAPSHOT_VERSION = 3;
+
+    /** Constructor / Destructor */
+    CSRGraph(std::pmr::memory_resource* memory = std::pmr::new_delete_resource());
+    ~CSRGraph();
+
+    CSRGraph(const CSRGraph&) = delete;
+    CSRGraph& operator=(const CSRGraph&) = delete;
+
+    /** Build Operations */
+    void reserve(size_t numNodes, size_t numEdges);
+    uint32_t addPath(std::string_view path);
+    uint32_t addNode(uint32_t path, std::string_view suffix, BFXNode::NodeType type, std::string_view name);
+    void addEdge(uint32_t src, uint32_t dst, BFXEdge::EdgeType type, uint32_t count = 1);
+    void build();
+
+    /** Node Accessors */
+    size_t getNumNodes() const;
+    std::string getID(uint32_t node) const;
+    std::string getName(uint32_t node) const;
+    BFXNode::NodeType getType(uint32_t node) const;
+    void appendID(std::string& out, uint32_t node) const;
+    void appendName(std::string& out, uint32_t node) const;
+    bool hasName(uint32_t node) const;
+    uint32_t getPath(uint32_t node) const;
+    std::string_view getSuffix(uint32_t node) const;
+
+    /** Path Accessors */
+    size_t getNumPaths() const;
+    void appendPath(std::string& out, uint32_t path) const;
+
+    /** Edge Accessors */
+    size_t getNumEdges(BFXEdge::EdgeType type) const;
+    Range getOutEdges(uint32_t node, BFXEdge::EdgeType type) const;
+    Range getOutCounts(uint32_t node, BFXEdge::EdgeType type) const;
+    Range getInEdges(uint32_t node, BFXEdge::EdgeType type) const;
+
+    /** Find Methods */
+    bool findNode(std::string_view ID, uint32_t& node) const;
+    bool doesEdgeExist(uint32_t src, uint32_t dst, BFXEdge::EdgeType type) const;
+
+    /** Snapshot Methods */
+    bool save(const std::string& path) const;
+    static CSRGraph* load(const std::string& path);
+
+private:
+    /** Edge Waiting to Be Laid Out */
+    struct StagedEdge {
+        uint32_t src;
+        uint32_t dst;
+        uint32_t count;
+    };
+
+    /** Adjacency Arrays for One Edge Type */
+    struct Adjacency {
+        std::pmr::vector<uint64_t> fwdOffsets;
+        std::pmr::vector<uint32_t> fwdTargets;
+        std::pmr::vector<uint32_t> fwdCounts;
+        std::pmr::vector<uint64_t> revOffsets;
+        std::pmr::vector<uint32_t> revSources;
+        std::pmr::vector<StagedEdge> staged;
+
+        explicit Adjacency(std::pmr::memory_resource* memory) : fwdOffsets(memory), fwdTargets(memory),
+                fwdCounts(memory), revOffsets(memory), revSources(memory), staged(memory) { }
+    };
+
+    /** Read-Only View of One Edge Type */
+    struct AdjacencyView {
+        const uint64_t* fwdOffsets;
+        const uint32_t* fwdTargets;
+        const uint32_t* fwdCounts;
+        const uint64_t* revOffsets;
+        const uint32_t* revSources;
+        uint64_t numEdges;
+    };
+
+    /** Snapshot File Layout */
+    struct SnapshotSection {
+        uint64_t numEdges;
+        uint64_t fwdOffsets;
+        uint64_t fwdTargets;
+        uint64_t fwdCounts;
+        uint64_t revOffsets;
+        uint64_t revSources;
+    };
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t edgeTypes;
+        uint32_t recordSize;
+        uint64_t fileBytes;
+        uint64_t numNodes;
+        uint64_t numPaths;
+        uint64_t stringOffset;
+        uint64_t stringBytes;
+        uint64_t pathOffset;
+        uint64_t nodeOffset;
+        SnapshotSection sections[EDGE_TYPES];
+    };
+
+    /** Private Variables (Allocated From the Graph's Storage) */
+    std::pmr::vector<char> strings;
+    std::pmr::vector<PathRecord> paths;
+    std::pmr::vector<NodeRecord> nodes;
+    std::vector<Adjacency> adjacency;
+    bool built;
+
+    /** Arrays Read by the Accessors (Owned or Mapped) */
+    const char* stringData;
+    const PathRecord* pathData;
+    const NodeRecord* nodeData;
+    uint64_t numNodes;
+    uint64_t numPaths;
+    AdjacencyView views[EDGE_TYPES];
+    void* mapping;
+    size_t mappingBytes;
+
+    /** Helper Methods */
+    void refreshViews();
+    bool checkRecords(uint64_t stringBytes) const;
+    uint64_t addString(std::string_view str);
+    int compareID(uint32_t node, std::string_view ID) const;
+    static void buildRows(size_t numNodes, const std::pmr::vector<StagedEdge>& edges, bool reverse,
+                          std::pmr::vector<uint64_t>& offsets, std::pmr::vector<uint32_t>& targets,
+                          std::pmr::vector<uint32_t>* counts);
+};
+
+#endif //BFX64_CSRGRAPH_H
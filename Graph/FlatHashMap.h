@@ -0,0 +1,473 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FlatHashMap.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Open-addressing hash map used for the graph indexes. Entries
+// live in one flat slot array alongside a byte of control data
+// per slot holding seven bits of the hash. Lookups compare a whole
+// group of control bytes at once (SSE2 when available) and only
+// touch a slot when its stored hash matches, so string keys are
+// rarely compared and never rehashed when the table grows.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_FLATHASHMAP_H
+#define BFX64_FLATHASHMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Transparent string hash and equality. Maps keyed by std::string
+ * that use these can be searched with a std::string_view (or a
+ * literal) without building a temporary string.
+ */
+struct StringHash {
+    typedef void is_transparent;
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+};
+struct StringEqual {
+    typedef void is_transparent;
+    bool operator()(std::string_view a, std::string_view b) const { return a == b; }
+};
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class FlatHashMap {
+public:
+    typedef std::pair<Key, Value> value_type;
+
+private:
+    /** Control Byte Values */
+    static const int8_t EMPTY = -128;
+    static const int8_t DELETED = -2;
+    static const size_t GROUP_WIDTH = 16;
+    static const size_t NPOS = (size_t) -1;
+
+    /** Slot Holding an Entry and its Full Hash */
+    struct Slot {
+        size_t hash;
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+        value_type& entry(){ return *reinterpret_cast<value_type*>(storage); }
+    };
+
+    /** Group of Control Bytes Matched Together */
+    struct Group {
+#ifdef __SSE2__
+        __m128i ctrl;
+        explicit Group(const int8_t* pos) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) { }
+
+        uint32_t match(int8_t h2) const {
+            return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+        }
+        uint32_t matchEmpty() const { return match(EMPTY); }
+        uint32_t matchFree() const { return (uint32_t) _mm_movemask_epi8(ctrl); }
+#else
+        const int8_t* ctrl;
+        explicit Group(const int8_t* pos) : ctrl(pos) { }
+
+        uint32_t match(int8_t h2) const {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++) if (ctrl[i] == h2) mask |= 1u << i;
+            return mask;
+        }
+        uint32_t matchEmpty() const { return match(EMPTY); }
+        uint32_t matchFree() const {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_WIDTH; i++) if (ctrl[i] < 0) mask |= 1u << i;
+            return mask;
+        }
+#endif
+    };
+
+public:
+    /** Iterator Over Full Slots */
+    template <bool Const>
+    class Iter {
+    public:
+        typedef typename std::conditional<Const, const value_type, value_type>::type entry_type;
+
+        Iter() : map(nullptr), index(0) { }
+        Iter(const FlatHashMap* map, size_t index) : map(map), index(index) { skip(); }
+        operator Iter<true>() const { return Iter<true>(map, index); }
+
+        entry_type& operator*() const { return map->slots[index].entry(); }
+        entry_type* operator->() const { return &map->slots[index].entry(); }
+        Iter& operator++(){ index++; skip(); return *this; }
+        Iter operator++(int){ Iter prev = *this; ++(*this); return prev; }
+        bool operator==(const Iter& other) const { return index == other.index; }
+        bool operator!=(const Iter& other) const { return index != other.index; }
+
+    private:
+        friend class FlatHashMap;
+        const FlatHashMap* map;
+        size_t index;
+
+        void skip(){ while (index < map->capacity && map->ctrl[index] < 0) index++; }
+    };
+    typedef Iter<false> iterator;
+    typedef Iter<true> const_iterator;
+
+    /** Constructor / Destructor */
+    FlatHashMap() : memory(std::pmr::new_delete_resource()), ctrl(nullptr), slots(nullptr),
+                    capacity(0), entries(0), tombstones(0) { }
+    ~FlatHashMap(){ destroyAll(); freeTables(); }
+
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+    FlatHashMap(FlatHashMap&& other) : FlatHashMap() { swap(other); }
+    FlatHashMap& operator=(FlatHashMap&& other){ swap(other); return *this; }
+
+    /** Capacity */
+    size_t size() const { return entries; }
+    bool empty() const { return entries == 0; }
+
+    /**
+     * Grows the table so that a number of entries fit
+     * without another rehash.
+     * @param n The number of entries expected.
+     */
+    void reserve(size_t n){
+        size_t needed = GROUP_WIDTH;
+        while (maxLoad(needed) < n) needed *= 2;
+        if (needed > capacity) rehash(needed);
+    }
+
+    /**
+     * Sets where the tables are allocated. Only takes effect
+     * before the first table is allocated.
+     * @param resource The memory resource.
+     */
+    void setResource(std::pmr::memory_resource* resource){
+        if (capacity == 0) memory = resource;
+    }
+
+    /**
+     * Removes every entry but keeps the allocated table.
+     */
+    void clear(){
+        destroyAll();
+        if (capacity != 0) memset(ctrl, EMPTY, capacity);
+        entries = 0;
+        tombstones = 0;
+    }
+
+    /** Iteration */
+    iterator begin(){ return iterator(this, 0); }
+    iterator end(){ return iterator(this, capacity); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, capacity); }
+
+    /**
+     * Finds an entry by key.
+     * @param key The key to look for.
+     * @return Iterator to the entry (or end()).
+     */
+    iterator find(const Key& key){
+        size_t index = findIndex(key, hashOf(key));
+        return (index == NPOS) ? end() : iterator(this, index);
+    }
+    const_iterator find(const Key& key) const {
+        size_t index = findIndex(key, hashOf(key));
+        return (index == NPOS) ? end() : const_iterator(this, index);
+    }
+
+    /**
+     * Finds an entry by a key of another type. Only available when
+     * the hash and equality are transparent, like StringHash.
+     * @param key The key to look for.
+     * @return Iterator to the entry (or end()).
+     */
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    iterator find(const K& key){
+        size_t index = findIndex(key, hashOf(key));
+        return (index == NPOS) ? end() : iterator(this, index);
+    }
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    const_iterator find(const K& key) const {
+        size_t index = findIndex(key, hashOf(key));
+        return (index == NPOS) ? end() : const_iterator(this, index);
+    }
+
+    /**
+     * Counts the entries matching a key.
+     * @param key The key to look for.
+     * @return 1 if found, 0 otherwise.
+     */
+    size_t count(const Key& key) const {
+        return (findIndex(key, hashOf(key)) == NPOS) ? 0 : 1;
+    }
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    size_t count(const K& key) const {
+        return (findIndex(key, hashOf(key)) == NPOS) ? 0 : 1;
+    }
+
+    /**
+     * Gets the value for a key, inserting a default one if missing.
+     * @param key The key to look for.
+     * @return Reference to the value.
+     */
+    Value& operator[](const Key& key){
+        return insertIndex(key, Value()).first->second;
+    }
+
+    /**
+     * Inserts an entry if the key does not exist.
+     * @param key The key.
+     * @param value The value.
+     * @return The entry and whether it was inserted.
+     */
+    std::pair<iterator, bool> insert(const Key& key, const Value& value){
+        return insertIndex(key, value);
+    }
+
+    /**
+     * Inserts an entry if the key does not exist, moving the key
+     * and value in so allocator-aware members keep their resource.
+     * @param key The key.
+     * @param value The value.
+     * @return The entry and whether it was inserted.
+     */
+    std::pair<iterator, bool> insert(Key&& key, Value&& value){
+        return insertIndex(std::move(key), std::move(value));
+    }
+
+    /**
+     * Removes an entry by key.
+     * @param key The key to remove.
+     * @return The number of entries removed.
+     */
+    size_t erase(const Key& key){
+        size_t index = findIndex(key, hashOf(key));
+        if (index == NPOS) return 0;
+
+        eraseIndex(index);
+        return 1;
+    }
+
+    /**
+     * Removes the entry at an iterator.
+     * @param it The entry to remove.
+     * @return Iterator to the following entry.
+     */
+    iterator erase(iterator it){
+        eraseIndex(it.index);
+        return iterator(this, it.index + 1);
+    }
+
+    /**
+     * Swaps the contents of two maps.
+     * @param other The map to swap with.
+     */
+    void swap(FlatHashMap& other){
+        std::swap(memory, other.memory);
+        std::swap(ctrl, other.ctrl);
+        std::swap(slots, other.slots);
+        std::swap(capacity, other.capacity);
+        std::swap(entries, other.entries);
+        std::swap(tombstones, other.tombstones);
+    }
+
+private:
+    /** Private Variables */
+    std::pmr::memory_resource* memory;
+    int8_t* ctrl;
+    Slot* slots;
+    size_t capacity;
+    size_t entries;
+    size_t tombstones;
+
+    /**
+     * Gets the maximum number of used slots for a capacity (7/8).
+     * @param cap The capacity.
+     * @return The maximum load.
+     */
+    static size_t maxLoad(size_t cap){ return cap - cap / 8; }
+
+    /**
+     * Hashes a key and mixes the bits so both the group index and
+     * the seven control bits are well distributed.
+     * @param key The key to hash.
+     * @return The mixed hash.
+     */
+    template <typename K>
+    static size_t hashOf(const K& key){
+        uint64_t h = (uint64_t) Hash()(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return (size_t) h;
+    }
+    static int8_t h2(size_t hash){ return (int8_t) (hash & 0x7F); }
+    size_t firstGroup(size_t hash) const { return (hash >> 7) & (capacity / GROUP_WIDTH - 1); }
+    size_t nextGroup(size_t group, size_t step) const { return (group + step) & (capacity / GROUP_WIDTH - 1); }
+
+    /**
+     * Probes the table for a key.
+     * @param key The key to look for.
+     * @param hash The mixed hash of the key.
+     * @return The slot index or NPOS.
+     */
+    template <typename K>
+    size_t findIndex(const K& key, size_t hash) const {
+        if (capacity == 0) return NPOS;
+
+        size_t group = firstGroup(hash);
+        for (size_t step = 1; ; step++){
+            Group grp(ctrl + group * GROUP_WIDTH);
+            for (uint32_t bits = grp.match(h2(hash)); bits != 0; bits &= bits - 1){
+                size_t index = group * GROUP_WIDTH + __builtin_ctz(bits);
+                if (slots[index].hash == hash && Equal()(slots[index].entry().first, key)) return index;
+            }
+            if (grp.matchEmpty() != 0) return NPOS;
+            group = nextGroup(group, step);
+        }
+    }
+
+    /**
+     * Finds the first empty or deleted slot for a hash.
+     * @param hash The mixed hash.
+     * @return The slot index.
+     */
+    size_t findFree(size_t hash) const {
+        size_t group = firstGroup(hash);
+        for (size_t step = 1; ; step++){
+            uint32_t bits = Group(ctrl + group * GROUP_WIDTH).matchFree();
+            if (bits != 0) return group * GROUP_WIDTH + __builtin_ctz(bits);
+            group = nextGroup(group, step);
+        }
+    }
+
+    /**
+     * Inserts a key if it doesn't exist.
+     * @param key The key.
+     * @param value The value for a new entry.
+     * @return The entry and whether it was inserted.
+     */
+    template <typename K, typename V>
+    std::pair<iterator, bool> insertIndex(K&& key, V&& value){
+        size_t hash = hashOf(key);
+        size_t index = findIndex(key, hash);
+        if (index != NPOS) return std::make_pair(iterator(this, index), false);
+
+        //Grow (or clean out tombstones) before we overfill.
+        if (entries + tombstones + 1 > maxLoad(capacity)){
+            rehash((entries + 1 > maxLoad(capacity) / 2 || capacity == 0) ? std::max(capacity * 2, GROUP_WIDTH) : capacity);
+        }
+
+        index = findFree(hash);
+        if (ctrl[index] == DELETED) tombstones--;
+        ctrl[index] = h2(hash);
+        slots[index].hash = hash;
+        new (slots[index].storage) value_type(std::forward<K>(key), std::forward<V>(value));
+        entries++;
+
+        return std::make_pair(iterator(this, index), true);
+    }
+
+    /**
+     * Destroys the entry in a slot. The slot goes back to empty if
+     * its group still has an empty slot, since then no probe ever
+     * continued past the group.
+     * @param index The slot index.
+     */
+    void eraseIndex(size_t index){
+        slots[index].entry().~value_type();
+        entries--;
+
+        size_t group = index - index % GROUP_WIDTH;
+        if (Group(ctrl + group).matchEmpty() != 0){
+            ctrl[index] = EMPTY;
+        } else {
+            ctrl[index] = DELETED;
+            tombstones++;
+        }
+    }
+
+    /**
+     * Moves every entry into a table of a new size using the
+     * stored hashes.
+     * @param newCapacity The new capacity.
+     */
+    void rehash(size_t newCapacity){
+        int8_t* oldCtrl = ctrl;
+        Slot* oldSlots = slots;
+        size_t oldCapacity = capacity;
+
+        ctrl = static_cast<int8_t*>(memory->allocate(newCapacity, GROUP_WIDTH));
+        memset(ctrl, EMPTY, newCapacity);
+        slots = static_cast<Slot*>(memory->allocate(newCapacity * sizeof(Slot), alignof(Slot)));
+        capacity = newCapacity;
+        tombstones = 0;
+
+        for (size_t i = 0; i < oldCapacity; i++){
+            if (oldCtrl[i] < 0) continue;
+
+            Slot& from = oldSlots[i];
+            size_t index = findFree(from.hash);
+            ctrl[index] = h2(from.hash);
+            slots[index].hash = from.hash;
+            new (slots[index].storage) value_type(std::move(from.entry()));
+            from.entry().~value_type();
+        }
+
+        if (oldCapacity == 0) return;
+        memory->deallocate(oldCtrl, oldCapacity, GROUP_WIDTH);
+        memory->deallocate(oldSlots, oldCapacity * sizeof(Slot), alignof(Slot));
+    }
+
+    /**
+     * Destroys every live entry.
+     */
+    void destroyAll(){
+        for (size_t i = 0; i < capacity && entries != 0; i++){
+            if (ctrl[i] >= 0) slots[i].entry().~value_type();
+        }
+    }
+
+    /**
+     * Frees the control and slot arrays.
+     */
+    void freeTables(){
+        if (capacity != 0){
+            memory->deallocate(ctrl, capacity, GROUP_WIDTH);
+            memory->deallocate(slots, capacity * sizeof(Slot), alignof(Slot));
+        }
+        ctrl = nullptr;
+        slots = nullptr;
+        capacity = 0;
+    }
+};
+
+template <typename Key, typename Value, typename Hash, typename Equal>
+const size_t FlatHashMap<Key, Value, Hash, Equal>::GROUP_WIDTH;
+
+#endif //BFX64_FLATHASHMAP_H
@@ -0,0 +1,220 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MappedArena.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Memory resource backed by a memory-mapped temporary file. Used
+// as the storage backend for graphs that are larger than physical
+// memory: node and edge records, their strings and the graph
+// indexes are carved out of shared file mappings, so the kernel
+// can write cold pages back to disk instead of the process running
+// out of memory.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "MappedArena.h"
+
+using namespace std;
+
+const size_t MappedArena::CHUNK_BYTES = 64 * 1024 * 1024;
+const size_t MappedArena::LARGE_BYTES = 256 * 1024;
+
+/**
+ * Creates the backing file. The file is unlinked right away so
+ * it never outlives the process.
+ * @param directory The directory to put the file in (empty for the temp directory).
+ */
+MappedArena::MappedArena(string directory){
+    if (directory.empty()){
+        const char* tmp = getenv("TMPDIR");
+        directory = (tmp != nullptr && *tmp != '\0') ? tmp : "/tmp";
+    }
+
+    string name = directory + "/bfx64-graph-XXXXXX";
+    fd = mkstemp(&name[0]);
+    if (fd != -1) unlink(name.c_str());
+
+    fileBytes = 0;
+    cursor = nullptr;
+    limit = nullptr;
+    mappedBytes = 0;
+    for (size_t i = 0; i < NUM_CLASSES; i++) freeLists[i] = nullptr;
+}
+
+/**
+ * Unmaps everything and closes the backing file.
+ */
+MappedArena::~MappedArena(){
+    for (const Mapping& chunk : chunks) unmapRegion(chunk, false);
+    for (auto& entry : large) unmapRegion(entry.second, false);
+    if (fd != -1) close(fd);
+}
+
+/**
+ * Checks whether the backing file was created.
+ * @return Boolean indicating whether the arena can allocate.
+ */
+bool MappedArena::isOpen() const {
+    return fd != -1;
+}
+
+/**
+ * Gets the number of bytes currently mapped from the file.
+ * @return The mapped bytes.
+ */
+size_t MappedArena::getMappedBytes(){
+    lock_guard<mutex> guard(lock);
+    return mappedBytes;
+}
+
+/**
+ * Allocates a block. Small blocks come from a free list or the
+ * current chunk, large ones get a mapping of their own.
+ * @param bytes The size of the block.
+ * @param alignment The alignment of the block.
+ * @return The block.
+ */
+void* MappedArena::do_allocate(size_t bytes, size_t alignment){
+    lock_guard<mutex> guard(lock);
+    if (fd == -1) throw bad_alloc();
+
+    size_t rounded;
+    int cls = sizeClass(bytes, rounded);
+    if (cls == -1){
+        Mapping mapping;
+        if (!mapRegion(bytes, mapping)) throw bad_alloc();
+        large.insert(mapping.base, mapping);
+        return mapping.base;
+    }
+
+    //Reuse a freed block of the same class.
+    if (alignment <= MIN_ALIGN && freeLists[cls] != nullptr){
+        FreeBlock* block = freeLists[cls];
+        freeLists[cls] = block->next;
+        return block;
+    }
+
+    //Carve the block out of the current chunk.
+    uintptr_t start = ((uintptr_t) cursor + alignment - 1) & ~((uintptr_t) alignment - 1);
+    if (cursor == nullptr || start + rounded > (uintptr_t) limit){
+        Mapping chunk;
+        if (!mapRegion(CHUNK_BYTES, chunk)) throw bad_alloc();
+        chunks.push_back(chunk);
+        cursor = chunk.base;
+        limit = chunk.base + chunk.bytes;
+        start = ((uintptr_t) cursor + alignment - 1) & ~((uintptr_t) alignment - 1);
+    }
+    cursor = (char*) (start + rounded);
+    return (void*) start;
+}
+
+/**
+ * Frees a block. Small blocks go on the free list of their
+ * class; large blocks are unmapped and dropped from the file.
+ * @param ptr The block.
+ * @param bytes The size of the block.
+ */
+void MappedArena::do_deallocate(void* ptr, size_t bytes, size_t /*alignment*/){
+    lock_guard<mutex> guard(lock);
+
+    size_t rounded;
+    int cls = sizeClass(bytes, rounded);
+    if (cls == -1){
+        auto it = large.find((char*) ptr);
+        if (it == large.end()) return;
+
+        unmapRegion(it->second, true);
+        large.erase(it);
+        return;
+    }
+
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = freeLists[cls];
+    freeLists[cls] = block;
+}
+
+/**
+ * Checks whether memory from one resource can be freed by another.
+ * @param other The other resource.
+ * @return Boolean indicating whether they are the same arena.
+ */
+bool MappedArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+/**
+ * Grows the file and maps the new range. The caller holds the lock.
+ * @param bytes The number of bytes needed.
+ * @param mapping The new mapping.
+ * @return Whether the range was mapped.
+ */
+bool MappedArena::mapRegion(size_t bytes, Mapping& mapping){
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    bytes = (bytes + page - 1) / page * page;
+
+    if (ftruncate(fd, (off_t) (fileBytes + bytes)) != 0) return false;
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t) fileBytes);
+    if (base == MAP_FAILED) return false;
+
+    mapping = Mapping{static_cast<char*>(base), bytes, fileBytes};
+    fileBytes += bytes;
+    mappedBytes += bytes;
+    return true;
+}
+
+/**
+ * Unmaps a range, optionally releasing its disk blocks. The
+ * caller holds the lock.
+ * @param mapping The mapping to remove.
+ * @param punch Whether to punch the range out of the file.
+ */
+void MappedArena::unmapRegion(const Mapping& mapping, bool punch){
+    munmap(mapping.base, mapping.bytes);
+    mappedBytes -= mapping.bytes;
+#ifdef FALLOC_FL_PUNCH_HOLE
+    if (punch) fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t) mapping.offset, (off_t) mapping.bytes);
+#else
+    (void) punch;
+#endif
+}
+
+/**
+ * Gets the size class of a block. Classes step by 16 bytes up
+ * to 256 bytes and then double.
+ * @param bytes The requested size.
+ * @param rounded The size of the class.
+ * @return The class, or -1 for a large block.
+ */
+int MappedArena::sizeClass(size_t bytes, size_t& rounded){
+    if (bytes > LARGE_BYTES) return -1;
+    if (bytes == 0) bytes = 1;
+
+    if (bytes <= 256){
+        rounded = (bytes + MIN_ALIGN - 1) / MIN_ALIGN * MIN_ALIGN;
+        return (int) (rounded / MIN_ALIGN) - 1;
+    }
+
+    int cls = 16;
+    for (rounded = 512; rounded < bytes; rounded *= 2) cls++;
+    return cls;
+}
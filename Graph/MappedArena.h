@@ -0,0 +1,102 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MappedArena.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Memory resource backed by a memory-mapped temporary file. Used
+// as the storage backend for graphs that are larger than physical
+// memory: node and edge records, their strings and the graph
+// indexes are carved out of shared file mappings, so the kernel
+// can write cold pages back to disk instead of the process running
+// out of memory.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_MAPPEDARENA_H
+#define BFX64_MAPPEDARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "FlatHashMap.h"
+
+/**
+ * Small blocks are bump allocated out of large chunks and recycled
+ * through per size class free lists. Large blocks get a mapping of
+ * their own, which is unmapped and punched out of the file when
+ * freed. Allocation is serialized by a single lock.
+ */
+class MappedArena : public std::pmr::memory_resource {
+public:
+    /** Constructor / Destructor */
+    MappedArena(std::string directory = "");
+    ~MappedArena();
+
+    MappedArena(const MappedArena&) = delete;
+    MappedArena& operator=(const MappedArena&) = delete;
+
+    /** Getters */
+    bool isOpen() const;
+    size_t getMappedBytes();
+
+protected:
+    /** Memory Resource Methods */
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+    /** Arena Tuning */
+    static const size_t CHUNK_BYTES;
+    static const size_t LARGE_BYTES;
+    static const size_t MIN_ALIGN = 16;
+    static const size_t NUM_CLASSES = 32;
+
+    /** One Mapped Range of the File */
+    struct Mapping {
+        char* base;
+        size_t bytes;
+        uint64_t offset;
+    };
+
+    /** Freed Small Block */
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    /** Private Variables */
+    std::mutex lock;
+    int fd;
+    uint64_t fileBytes;
+    char* cursor;
+    char* limit;
+    size_t mappedBytes;
+    std::vector<Mapping> chunks;
+    FlatHashMap<char*, Mapping> large;
+    FreeBlock* freeLists[NUM_CLASSES];
+
+    /** Helper Methods */
+    bool mapRegion(size_t bytes, Mapping& mapping);
+    void unmapRegion(const Mapping& mapping, bool punch);
+    static int sizeClass(size_t bytes, size_t& rounded);
+};
+
+#endif //BFX64_MAPPEDARENA_H
@@ -0,0 +1,176 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ObjectPool.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Arena that hands out graph objects from large, contiguous
+// chunks instead of individual heap allocations. Objects can be
+// destroyed one at a time (their slot is recycled) or all at once,
+// which keeps the chunks around for the next round of inserts.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_OBJECTPOOL_H
+#define BFX64_OBJECTPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class ObjectPool {
+public:
+    /** Constructor / Destructor */
+    explicit ObjectPool(size_t chunkSize = DEFAULT_CHUNK) : memory(std::pmr::new_delete_resource()),
+            chunkSize(chunkSize), used(0), freeList(nullptr), live(0) { }
+    ~ObjectPool(){ release(); }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    /**
+     * Constructs a new object in the pool.
+     * @param args The constructor arguments.
+     * @return A pointer to the new object.
+     */
+    template <typename... Args>
+    T* create(Args&&... args){
+        Slot* slot = nextSlot();
+        T* obj = new (slot->storage) T(std::forward<Args>(args)...);
+        slot->live = true;
+        live++;
+        return obj;
+    }
+
+    /**
+     * Sets where the chunks are allocated. Only takes effect
+     * before the first chunk is allocated.
+     * @param resource The memory resource.
+     */
+    void setResource(std::pmr::memory_resource* resource){
+        if (chunks.empty()) memory = resource;
+    }
+
+    /**
+     * Destroys a single object and recycles its slot.
+     * @param obj The object to destroy.
+     */
+    void destroy(T* obj){
+        if (obj == nullptr) return;
+        Slot* slot = reinterpret_cast<Slot*>(obj);
+
+        obj->~T();
+        slot->live = false;
+        slot->next = freeList;
+        freeList = slot;
+        live--;
+    }
+
+    /**
+     * Destroys every object in the pool in a single pass over
+     * the chunks. The chunks are kept for reuse.
+     */
+    void reset(){
+        forEachSlot([](Slot* slot){
+            if (slot->live){
+                reinterpret_cast<T*>(slot->storage)->~T();
+                slot->live = false;
+            }
+        });
+        used = 0;
+        freeList = nullptr;
+        live = 0;
+    }
+
+    /**
+     * Destroys every object and returns all chunks to the system.
+     */
+    void release(){
+        reset();
+        for (Slot* chunk : chunks) memory->deallocate(chunk, chunkSize * sizeof(Slot), alignof(Slot));
+        chunks.clear();
+    }
+
+    /**
+     * Gets the number of live objects.
+     * @return The number of objects.
+     */
+    size_t size() const { return live; }
+
+    /**
+     * Gets the number of bytes reserved by the pool.
+     * @return The reserved bytes.
+     */
+    size_t capacityBytes() const { return chunks.size() * chunkSize * sizeof(Slot); }
+
+    static const size_t DEFAULT_CHUNK = 4096;
+
+private:
+    /** Storage Slot */
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        Slot* next;
+        bool live;
+    };
+
+    /** Private Variables */
+    std::pmr::memory_resource* memory;
+    size_t chunkSize;
+    size_t used;
+    Slot* freeList;
+    size_t live;
+    std::vector<Slot*> chunks;
+
+    /**
+     * Gets a free slot, either recycled or from the tail chunk.
+     * @return The slot.
+     */
+    Slot* nextSlot(){
+        if (freeList != nullptr){
+            Slot* slot = freeList;
+            freeList = slot->next;
+            return slot;
+        }
+
+        //Move to the next chunk when the current one is full.
+        size_t chunk = used / chunkSize;
+        if (chunk == chunks.size()){
+            Slot* fresh = static_cast<Slot*>(memory->allocate(chunkSize * sizeof(Slot), alignof(Slot)));
+            for (size_t i = 0; i < chunkSize; i++) fresh[i].live = false;
+            chunks.push_back(fresh);
+        }
+        return &chunks[chunk][used++ % chunkSize];
+    }
+
+    /**
+     * Runs a function on every handed out slot.
+     * @param fn The function to run.
+     */
+    template <typename Fn>
+    void forEachSlot(Fn fn){
+        for (size_t i = 0; i < used; i++) fn(&chunks[i / chunkSize][i % chunkSize]);
+    }
+};
+
+template <typename T>
+const size_t ObjectPool<T>::DEFAULT_CHUNK;
+
+#endif //BFX64_OBJECTPOOL_H
@@ -0,0 +1,274 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PathTrie.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Trie of path segments used to store node IDs compactly. Every
+// ID is an absolute path, optionally followed by a bracketed
+// section and offset. The path is interned into the trie once and
+// the ID keeps a reference to its trie node plus the short suffix.
+// Full IDs are only rebuilt when the graph is written out.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include "PathTrie.h"
+
+using namespace std;
+
+/**
+ * Creates a trie holding only the empty path.
+ * @param memory Where the segments and the child index are allocated.
+ */
+PathTrie::PathTrie(pmr::memory_resource* memory) : memory(memory), segments(memory) {
+    children.setResource(memory);
+    segments.push_back(Segment{ROOT, pmr::string(memory)});
+}
+
+/**
+ * Default destructor.
+ */
+PathTrie::~PathTrie(){ }
+
+/**
+ * Adds a path to the trie, reusing every segment that is
+ * already there. Safe to call from several threads.
+ * @param path The path to add.
+ * @return The trie node of the path.
+ */
+uint32_t PathTrie::intern(string_view path){
+    uint32_t node;
+    size_t consumed;
+
+    //Most paths are already known.
+    {
+        shared_lock<shared_mutex> guard(lock);
+        if (walk(path, node, consumed)) return node;
+    }
+
+    //Walk again under the write lock and add what's missing.
+    unique_lock<shared_mutex> guard(lock);
+    if (walk(path, node, consumed)) return node;
+
+    while (consumed < path.size()){
+        size_t end = nextSegment(path, consumed);
+        uint32_t child = (uint32_t) segments.size();
+        segments.push_back(Segment{node, pmr::string(path.substr(consumed, end - consumed), memory)});
+
+        //The key views the segment's own text.
+        children.insert(ChildKey{node, segments.back().text}, child);
+        node = child;
+        consumed = end;
+    }
+
+    return node;
+}
+
+/**
+ * Finds a path without adding it.
+ * @param path The path to look for.
+ * @param node The trie node of the path, if found.
+ * @return Boolean indicating whether the path was found.
+ */
+bool PathTrie::find(string_view path, uint32_t& node) const {
+    size_t consumed;
+    shared_lock<shared_mutex> guard(lock);
+    return walk(path, node, consumed);
+}
+
+/**
+ * Appends the full path of a trie node to a string. The
+ * segments are copied straight into place from the leaf up.
+ * @param out The string to append to.
+ * @param node The trie node.
+ */
+void PathTrie::appendPath(string& out, uint32_t node) const {
+    shared_lock<shared_mutex> guard(lock);
+
+    size_t length = 0;
+    for (uint32_t curr = node; curr != ROOT; curr = segments[curr].parent) length += segments[curr].text.size();
+
+    size_t end = out.size() + length;
+    out.resize(end);
+    for (uint32_t curr = node; curr != ROOT; curr = segments[curr].parent){
+        const pmr::string& text = segments[curr].text;
+        end -= text.size();
+        memcpy(&out[end], text.data(), text.size());
+    }
+}
+
+/**
+ * Gets the full path of a trie node.
+ * @param node The trie node.
+ * @return The path.
+ */
+string PathTrie::getPath(uint32_t node) const {
+    string path;
+    appendPath(path, node);
+    return path;
+}
+
+/**
+ * Splits an ID into its path and suffix, adding the path
+ * to the trie.
+ * @param ID The full ID.
+ * @return The compact ID.
+ */
+CompactID PathTrie::compact(string_view ID){
+    size_t split = suffixStart(ID);
+    return CompactID{intern(ID.substr(0, split)), pmr::string(ID.substr(split))};
+}
+
+/**
+ * Splits an ID into its path and suffix without adding the
+ * path. An unknown path means no node can have the ID.
+ * @param ID The full ID.
+ * @param compactID The compact ID, viewing the suffix of ID.
+ * @return Boolean indicating whether the path was found.
+ */
+bool PathTrie::lookup(string_view ID, CompactIDView& compactID) const {
+    size_t split = suffixStart(ID);
+    if (!find(ID.substr(0, split), compactID.path)) return false;
+
+    compactID.suffix = ID.substr(split);
+    return true;
+}
+
+/**
+ * Appends a full ID to a string.
+ * @param out The string to append to.
+ * @param ID The compact ID.
+ */
+void PathTrie::appendID(string& out, const CompactIDView& ID) const {
+    appendPath(out, ID.path);
+    out.append(ID.suffix.data(), ID.suffix.size());
+}
+
+/**
+ * Rebuilds a full ID.
+ * @param ID The compact ID.
+ * @return The full ID.
+ */
+string PathTrie::getID(const CompactIDView& ID) const {
+    string full;
+    appendID(full, ID);
+    return full;
+}
+
+/**
+ * Compares two IDs in the order of their full strings.
+ * @param a The first ID.
+ * @param b The second ID.
+ * @return Negative, zero or positive like strcmp.
+ */
+int PathTrie::compare(const CompactIDView& a, const CompactIDView& b) const {
+    if (a.path == b.path) return a.suffix.compare(b.suffix);
+
+    string aPath = getPath(a.path);
+    string bPath = getPath(b.path);
+    return compareJoined(aPath, a.suffix, bPath, b.suffix);
+}
+
+/**
+ * Gets the number of trie nodes, including the root.
+ * @return The number of nodes.
+ */
+size_t PathTrie::size() const {
+    shared_lock<shared_mutex> guard(lock);
+    return segments.size();
+}
+
+/**
+ * Finds where the suffix of an ID starts. Symbol IDs end with
+ * a bracketed section and offset; file and subsystem IDs are
+ * all path.
+ * @param ID The full ID.
+ * @return The index of the first suffix character.
+ */
+size_t PathTrie::suffixStart(string_view ID){
+    if (ID.empty() || ID.back() != ']') return ID.size();
+
+    size_t open = ID.rfind('[');
+    return (open == string_view::npos) ? ID.size() : open;
+}
+
+/**
+ * Compares two strings that are each split in two pieces,
+ * as if the pieces were joined.
+ * @param aPath The start of the first string.
+ * @param aSuffix The end of the first string.
+ * @param bPath The start of the second string.
+ * @param bSuffix The end of the second string.
+ * @return Negative, zero or positive like strcmp.
+ */
+int PathTrie::compareJoined(string_view aPath, string_view aSuffix, string_view bPath, string_view bSuffix){
+    string_view a[2] = {aPath, aSuffix};
+    string_view b[2] = {bPath, bSuffix};
+    int ai = 0, bi = 0;
+
+    while (true){
+        while (ai < 2 && a[ai].empty()) ai++;
+        while (bi < 2 && b[bi].empty()) bi++;
+        if (ai == 2 || bi == 2) return (ai == 2) ? ((bi == 2) ? 0 : -1) : 1;
+
+        //Compare the overlap of the current pieces.
+        size_t len = min(a[ai].size(), b[bi].size());
+        int cmp = memcmp(a[ai].data(), b[bi].data(), len);
+        if (cmp != 0) return (cmp < 0) ? -1 : 1;
+        a[ai].remove_prefix(len);
+        b[bi].remove_prefix(len);
+    }
+}
+
+/**
+ * Follows a path down the trie as far as it exists. The
+ * caller holds the lock.
+ * @param path The path to follow.
+ * @param node The deepest trie node reached.
+ * @param consumed The number of path characters matched.
+ * @return Boolean indicating whether the whole path was found.
+ */
+bool PathTrie::walk(string_view path, uint32_t& node, size_t& consumed) const {
+    node = ROOT;
+    consumed = 0;
+
+    while (consumed < path.size()){
+        size_t end = nextSegment(path, consumed);
+        auto it = children.find(ChildKey{node, path.substr(consumed, end - consumed)});
+        if (it == children.end()) return false;
+
+        node = it->second;
+        consumed = end;
+    }
+
+    return true;
+}
+
+/**
+ * Gets the end of the segment starting at an index. Each
+ * segment runs up to (not including) the next separator.
+ * @param path The path.
+ * @param start The start of the segment.
+ * @return The end of the segment.
+ */
+size_t PathTrie::nextSegment(string_view path, size_t start){
+    size_t end = path.find('/', start + 1);
+    return (end == string_view::npos) ? path.size() : end;
+}
@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PathTrie.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Trie of path segments used to store node IDs compactly. Every
+// ID is an absolute path, optionally followed by a bracketed
+// section and offset. The path is interned into the trie once and
+// the ID keeps a reference to its trie node plus the short suffix.
+// Full IDs are only rebuilt when the graph is written out.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_PATHTRIE_H
+#define BFX64_PATHTRIE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include "FlatHashMap.h"
+
+/**
+ * View of a compact node ID. The suffix points into storage
+ * owned elsewhere (a node, an edge or the caller's string).
+ */
+struct CompactIDView {
+    uint32_t path;
+    std::string_view suffix;
+
+    bool operator==(const CompactIDView& other) const {
+        return path == other.path && suffix == other.suffix;
+    }
+};
+
+/**
+ * Node ID stored as a trie node and the text after the path.
+ * The suffix is allocated wherever its owner's storage is.
+ */
+struct CompactID {
+    uint32_t path;
+    std::pmr::string suffix;
+
+    CompactIDView view() const { return CompactIDView{path, suffix}; }
+};
+
+/**
+ * Hash for compact ID views.
+ */
+struct CompactIDHash {
+    size_t operator()(const CompactIDView& ID) const {
+        uint64_t h = (uint64_t) std::hash<std::string_view>()(ID.suffix);
+        return (size_t) (h ^ ((uint64_t) ID.path * 0x9e3779b97f4a7c15ULL));
+    }
+};
+
+class PathTrie {
+public:
+    /** The Empty Path */
+    static const uint32_t ROOT = 0;
+
+    /** Constructor / Destructor */
+    PathTrie(std::pmr::memory_resource* memory = std::pmr::new_delete_resource());
+    ~PathTrie();
+
+    PathTrie(const PathTrie&) = delete;
+    PathTrie& operator=(const PathTrie&) = delete;
+
+    /** Path Operations */
+    uint32_t intern(std::string_view path);
+    bool find(std::string_view path, uint32_t& node) const;
+    void appendPath(std::string& out, uint32_t node) const;
+    std::string getPath(uint32_t node) const;
+
+    /** ID Operations */
+    CompactID compact(std::string_view ID);
+    bool lookup(std::string_view ID, CompactIDView& compactID) const;
+    void appendID(std::string& out, const CompactIDView& ID) const;
+    std::string getID(const CompactIDView& ID) const;
+    int compare(const CompactIDView& a, const CompactIDView& b) const;
+
+    /** Getters */
+    size_t size() const;
+
+    /** Helper Methods */
+    static size_t suffixStart(std::string_view ID);
+    static int compareJoined(std::string_view aPath, std::string_view aSuffix,
+                             std::string_view bPath, std::string_view bSuffix);
+
+private:
+    /** One Path Segment (Starts at a Separator) */
+    struct Segment {
+        uint32_t parent;
+        std::pmr::string text;
+    };
+
+    /** Child Lookup Key */
+    struct ChildKey {
+        uint32_t parent;
+        std::string_view text;
+
+        bool operator==(const ChildKey& other) const {
+            return parent == other.parent && text == other.text;
+        }
+    };
+    struct ChildKeyHash {
+        size_t operator()(const ChildKey& key) const {
+            return CompactIDHash()(CompactIDView{key.parent, key.text});
+        }
+    };
+
+    /** Private Variables */
+    mutable std::shared_mutex lock;
+    std::pmr::memory_resource* memory;
+    std::pmr::deque<Segment> segments;
+    FlatHashMap<ChildKey, uint32_t, ChildKeyHash> children;
+
+    /** Helper Methods */
+    bool walk(std::string_view path, uint32_t& node, size_t& consumed) const;
+    static size_t nextSegment(std::string_view path, size_t start);
+};
+
+#endif //BFX64_PATHTRIE_H
@@ -25,41 +25,79 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cstdint>
 #include "TAGraph.h"
 
 using namespace std;
 
+const uint32_t TAGraph::NO_OWNER;
+const char TAGraph::LINK_SEPARATOR;
+
 /**
  * Constructor that creates a blank graph of
- * nodes and edges. Takes no parameters to
- * initialize.
+ * nodes and edges.
+ * @param lowMemory Whether the graph is purged during analysis.
+ * @param storage The arena to keep the graph in (or nullptr for the heap). The graph takes ownership.
  */
-TAGraph::TAGraph(bool lowMemory){
-    //Create a blank graph.
-    nodeList = unordered_map<string, BFXNode*>();
-    edgeList = unordered_map<string, BFXEdge*>();
-    mangleList = unordered_map<string, vector<string>>();
-
+TAGraph::TAGraph(bool lowMemory, MappedArena* storage) : storage(storage),
+        memory((storage != nullptr) ? (pmr::memory_resource*) storage : pmr::new_delete_resource()), paths(memory) {
     //Sets the low memory flag.
-    if (lowMemory) {
-        this->lowMem = lowMemory;
-        nodeBitList = unordered_map<string, bool>();
-        edgeBitList = unordered_map<string, bool>();
+    this->lowMem = lowMemory;
+    if (storage == nullptr) return;
+
+    //Point the pools and indexes at the arena before anything is allocated.
+    for (size_t i = 0; i < NUM_SHARDS; i++){
+        nodeShards[i].nodes.setResource(memory);
+        nodeShards[i].pool.setResource(memory);
+        edgeShards[i].edges.setResource(memory);
+        edgeShards[i].pool.setResource(memory);
+        mangleShards[i].IDs.setResource(memory);
     }
 }
 
 /**
- * Destructor for TAGraph. Deletes all the
- * nodes and edges in the graph.
+ * Constructor that wraps an already frozen graph, such
+ * as one loaded from a snapshot. The graph takes ownership.
+ * @param frozenGraph The frozen graph.
+ */
+TAGraph::TAGraph(CSRGraph* frozenGraph){
+    this->frozen = frozenGraph;
+}
+
+/**
+ * Destructor for TAGraph. The node and edge
+ * pools free everything in the graph.
  */
 TAGraph::~TAGraph(){
-    //Delete all sub elements in vectors.
-    for (auto it = edgeList.begin(); it != edgeList.end(); it++)
-        delete it->second;
-    edgeList.erase(edgeList.begin(), edgeList.end());
-    for (auto it = nodeList.begin(); it != nodeList.end(); it++)
-        delete it->second;
-    nodeList.erase(nodeList.begin(), nodeList.end());
+    //The pools release all nodes and edges in bulk.
+    delete frozen;
+}
+
+/**
+ * Sizes the indexes ahead of time so they don't rehash
+ * while files are processed. Counts are estimates for the
+ * whole run taken from the file discovery phase.
+ * @param numNodes The expected number of nodes.
+ * @param numEdges The expected number of edges.
+ * @param numMangles The expected number of mangled names.
+ */
+void TAGraph::reserve(size_t numNodes, size_t numEdges, size_t numMangles){
+    size_t nodesPerShard = numNodes / NUM_SHARDS + 1;
+    size_t edgesPerShard = numEdges / NUM_SHARDS + 1;
+    size_t manglesPerShard = numMangles / NUM_SHARDS + 1;
+    for (size_t i = 0; i < NUM_SHARDS; i++) mangleShards[i].IDs.reserve(manglesPerShard);
+
+    //In low memory mode only the node filter lives for the whole run.
+    if (lowMem){
+        nodeFilter.reserve(numNodes);
+        return;
+    }
+
+    for (size_t i = 0; i < NUM_SHARDS; i++){
+        nodeShards[i].nodes.reserve(nodesPerShard);
+        edgeShards[i].edges.reserve(edgesPerShard);
+    }
 }
 
 /**
@@ -73,41 +111,79 @@ TAGraph::~TAGraph(){
  * @return Boolean indicating whether the node was added.
  */
 bool TAGraph::addNode(string ID, BFXNode::NodeType type, string name, string mangledName) {
-    BFXNode* curr = findNode(ID);
-
-    //Search to see if ID exists.
-    if (curr != nullptr){
-        //Check if we should add the mangled name.
-        if (!curr->doesMangledNameExist(mangledName)) {
+    if (frozen != nullptr) return false;
+    CompactID compactID = paths.compact(ID);
+    NodeShard& shard = nodeShard(compactID.view());
+    bool created = false;
+
+    {
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.nodes.find(compactID.view());
+
+        //Search to see if ID exists.
+        if (it != shard.nodes.end() && it->second != nullptr){
+            //Check if we should add the mangled name.
+            BFXNode* curr = it->second;
+            if (curr->doesMangledNameExist(mangledName)) return false;
             curr->addMangledName(mangledName);
-            mangleList[mangledName].push_back(ID);
+            liveBytes += sizeof(string) + mangledName.size();
+        } else {
+            //Start by creating a new node. The index keys on its own ID.
+            BFXNode* newNode = shard.pool.create(compactID, type, name, vector<string>(1, mangledName), memory);
+            shard.nodes.insert(newNode->getID().view(), newNode);
+            liveBytes += nodeBytes(newNode);
+            created = true;
         }
-        return false;
     }
 
-    //Start by creating a new node.
-    vector<string> mangledNames = vector<string>();
-    mangledNames.push_back(mangledName);
-
     //Adds the mangled name to the list.
-    mangleList[mangledName].push_back(ID);
+    addMangle(mangledName, compactID);
+    if (!created) return false;
 
-    BFXNode* newNode = new BFXNode(ID, type, name, mangledNames);
-    nodeList[ID] = newNode;
+    //Adds the node to the filter.
+    if (lowMem){
+        lock_guard<mutex> guard(filterLock);
+        nodeFilter.insert(ID);
+    }
 
-    //Adds the node to the bit list.
-    if (lowMem) nodeBitList[ID] = true;
+    return true;
+}
 
+/**
+ * Makes a mangled name resolve to an existing node without
+ * storing the name on the node. Used to lift symbols onto the
+ * file or subsystem that defines them, so references between
+ * symbols become edges between their owners.
+ * @param ID The ID of the node that owns the symbol.
+ * @param mangledName The mangled name of the symbol.
+ * @return Boolean indicating whether the alias was added.
+ */
+bool TAGraph::addAlias(string_view ID, const string& mangledName){
+    if (frozen != nullptr) return false;
+
+    //The caller added the owner, so no existence check is needed.
+    addMangle(mangledName, paths.compact(ID));
     return true;
 }
 
+/**
+ * Removes every node and edge from the graph. The pools are
+ * reset in bulk and keep their chunks for the next inserts.
+ * The node filter and mangle list survive so later files can
+ * still link against purged nodes. Duplicate edges across
+ * purges are merged away on output.
+ * @return Boolean indicating success.
+ */
 bool TAGraph::removeAllNodes(){
-    for (auto it = edgeList.begin(); it != edgeList.end(); it++)
-        delete it->second;
-    edgeList.erase(edgeList.begin(), edgeList.end());
-    for (auto it = nodeList.begin(); it != nodeList.end(); it++)
-        delete it->second;
-    nodeList.erase(nodeList.begin(), nodeList.end());
+    for (size_t i = 0; i < NUM_SHARDS; i++){
+        edgeShards[i].edges.clear();
+        edgeShards[i].pool.reset();
+    }
+    for (size_t i = 0; i < NUM_SHARDS; i++){
+        nodeShards[i].nodes.clear();
+        nodeShards[i].pool.reset();
+    }
+    liveBytes = 0;
 
     return true;
 }
@@ -117,17 +193,37 @@ bool TAGraph::removeAllNodes(){
  * @param ID The ID to remove.
  * @return Boolean indicating success.
  */
-bool TAGraph::removeNode(string ID) {
-    //Get the node.
-    BFXNode* node = nodeList[ID];
-    if (node == nullptr) return false;
+bool TAGraph::removeNode(string_view ID) {
+    if (frozen != nullptr) return false;
 
-    //Deletes the node.
-    nodeList.erase(ID);
+    //Get the node.
+    CompactIDView compactID;
+    if (!paths.lookup(ID, compactID)) return false;
+    NodeShard& shard = nodeShard(compactID);
+    auto it = shard.nodes.find(compactID);
+    if (it == shard.nodes.end() || it->second == nullptr) return false;
+    BFXNode* node = it->second;
+
+    //Removes all edges touching the node.
+    removeAllEdges(node);
+
+    //Drops the node from the mangle list.
+    for (string_view mangle : node->getMangledNames()){
+        MangleShard& mangles = mangleShard(mangle);
+        auto mangleIt = mangles.IDs.find(mangle);
+        if (mangleIt == mangles.IDs.end()) continue;
+
+        pmr::vector<CompactID>& IDs = mangleIt->second;
+        IDs.erase(remove_if(IDs.begin(), IDs.end(), [node](const CompactID& curr){
+            return curr.view() == node->getID().view();
+        }), IDs.end());
+        if (IDs.size() == 0) mangles.IDs.erase(mangleIt);
+    }
 
-    //Removes all edges.
-    removeAllEdges(ID);
-    delete node;
+    //Unindexes the node before its ID goes away.
+    shard.nodes.erase(it);
+    liveBytes -= min(nodeBytes(node), liveBytes.load());
+    shard.pool.destroy(node);
     return true;
 }
 
@@ -139,56 +235,55 @@ bool TAGraph::removeNode(string ID) {
  * @param type The type of edge (See BFXEdge)
  * @return Boolean indicating success.
  */
-bool TAGraph::addEdge(string srcID, string dstID, BFXEdge::EdgeType type) {
-    BFXEdge* newEdge;
+bool TAGraph::addEdge(string_view srcID, string_view dstID, BFXEdge::EdgeType type) {
+    if (frozen != nullptr) return false;
+
+    //IDs with an unknown path were never added.
+    CompactIDView srcCompact, dstCompact;
+    if (!paths.lookup(srcID, srcCompact) || !paths.lookup(dstID, dstCompact)) return false;
+
+    //Check if the edge already exists.
+    if (findEdge(srcCompact, dstCompact, type) != nullptr) return true;
 
     //Adds the edge depending on the memory type.
     if (lowMem){
-        //Check if the edges exist.
-        if (!nodeBitList[srcID] || !nodeBitList[dstID]) return false;
+        //Check if the nodes exist.
+        if (!nodeExists(srcID, srcCompact) || !nodeExists(dstID, dstCompact)) return false;
 
         //Add the edge by ID.
-        newEdge = new BFXEdge(srcID, dstID, type);
+        insertEdge(srcCompact, dstCompact, nullptr, nullptr, type, false);
     } else {
         //Get the two nodes.
-        BFXNode* src = findNode(srcID);
-        BFXNode* dst = findNode(dstID);
+        BFXNode* src = findNode(srcCompact);
+        BFXNode* dst = findNode(dstCompact);
 
         //Check if they exist.
         if (src == nullptr || dst == nullptr) return false;
 
         //Create the edge.
-        newEdge = new BFXEdge(src, dst, type);
+        insertEdge(srcCompact, dstCompact, src, dst, type, false);
     }
 
-    edgeList[srcID + dstID + BFXEdge::getTypeString(type)] = newEdge;
-
-    //If we're in low memory mode, set the edge field.
-    if (lowMem) edgeBitList[srcID + dstID + BFXEdge::getTypeString(type)] = true;
-
     return true;
 }
 
 /**
  * Adds an edge to the graph based on two already added nodes. Checks
- * based on mangle name and NOT ID name.
+ * based on mangle name and NOT ID name. Adding an edge that already
+ * exists bumps its reference count instead.
  * @param srcID The mangle ID of the source.
  * @param dstID The mangle ID of the destination.
  * @param type The type of edge (See BFXEdge)
  * @return Boolean indicating success.
  */
-bool TAGraph::addEdgeByMangle(string srcID, string dstID, BFXEdge::EdgeType type){
-    BFXEdge* newEdge;
+bool TAGraph::addEdgeByMangle(string_view srcID, string_view dstID, BFXEdge::EdgeType type){
+    if (frozen != nullptr) return false;
 
     if (lowMem){
-        string src = findNodeIDByMangle(srcID);
-        string dst = findNodeIDByMangle(dstID);
-        if (src.compare("") == 0 || dst.compare("") == 0) return false;
-
-        //Check if the nodes exist.
-        if (!nodeBitList[src] || !nodeBitList[dst]) return false;
-
-        newEdge = new BFXEdge(src, dst, type);
+        //The IDs came from the mangle list, so the nodes were added.
+        CompactID src, dst;
+        if (!findNodeIDByMangle(srcID, src) || !findNodeIDByMangle(dstID, dst)) return false;
+        insertEdge(src.view(), dst.view(), nullptr, nullptr, type, true);
     } else {
         //Get the two nodes.
         BFXNode* src = findNodeByMangle(srcID);
@@ -198,14 +293,9 @@ bool TAGraph::addEdgeByMangle(string srcID, string dstID, BFXEdge::EdgeType type
         if (src == nullptr || dst == nullptr) return false;
 
         //Create the edge.
-        newEdge = new BFXEdge(src, dst, type);
+        insertEdge(src->getID().view(), dst->getID().view(), src, dst, type, true);
     }
 
-    edgeList[newEdge->getSrcID() + newEdge->getDstID() + BFXEdge::getTypeString(type)] = newEdge;
-
-    //If we're in low memory mode, set the edge field.
-    if (lowMem) edgeBitList[newEdge->getSrcID() + newEdge->getDstID() + BFXEdge::getTypeString(type)] = true;
-
     return true;
 }
 
@@ -217,18 +307,119 @@ bool TAGraph::addEdgeByMangle(string srcID, string dstID, BFXEdge::EdgeType type
  * @param type The edge type to remove.
  * @return Boolean indicating success.
  */
-bool TAGraph::removeEdge(string srcID, string dstID, BFXEdge::EdgeType type) {
-    //Check if a node exists.
-    BFXEdge* edge = edgeList[srcID + dstID + BFXEdge::getTypeString(type)];
-    if (edge == nullptr) return false;
+bool TAGraph::removeEdge(string_view srcID, string_view dstID, BFXEdge::EdgeType type) {
+    if (frozen != nullptr) return false;
+
+    //Check if the edge exists.
+    EdgeKey key;
+    if (!paths.lookup(srcID, key.src) || !paths.lookup(dstID, key.dst)) return false;
+    key.type = type;
+    EdgeShard& shard = edgeShard(key);
+    auto it = shard.edges.find(key);
+    if (it == shard.edges.end() || it->second == nullptr) return false;
+    BFXEdge* edge = it->second;
+
+    //Unhooks and deletes the edge.
+    shard.edges.erase(it);
+    detachEdge(edge);
+    liveBytes -= min(edgeBytes(edge), liveBytes.load());
+    shard.pool.destroy(edge);
+
+    return true;
+}
 
-    //Set nullptr on the edge.
-    edgeList.erase(srcID + dstID + BFXEdge::getTypeString(type));
-    delete edge;
+/**
+ * Freezes the graph into a compressed-sparse-row layout. Nodes
+ * are ordered by ID and each edge type gets sorted forward and
+ * reverse arrays. The mutable maps are released afterwards, so
+ * no more nodes or edges can be added. Not used in low memory
+ * mode since edges there may point at purged nodes.
+ * @return Boolean indicating whether the graph was frozen.
+ */
+bool TAGraph::finalize(){
+    if (frozen != nullptr || lowMem) return false;
+
+    //Rebuild each distinct path once so IDs can be ordered.
+    vector<BFXNode*> order;
+    vector<string> pathText(paths.size());
+    vector<uint32_t> csrPath(paths.size(), UINT32_MAX);
+    for (size_t i = 0; i < NUM_SHARDS; i++){
+        FlatHashMap<CompactIDView, BFXNode*, CompactIDHash>& nodes = nodeShards[i].nodes;
+        for (auto it = nodes.begin(); it != nodes.end(); it++){
+            if (it->second == nullptr) continue;
+            order.push_back(it->second);
+
+            uint32_t path = it->first.path;
+            if (path != PathTrie::ROOT && pathText[path].empty()) pathText[path] = paths.getPath(path);
+        }
+    }
+
+    //Order the nodes by ID so the node table is searchable.
+    sort(order.begin(), order.end(), [&pathText](BFXNode* a, BFXNode* b){
+        const CompactID& aID = a->getID();
+        const CompactID& bID = b->getID();
+        return PathTrie::compareJoined(pathText[aID.path], aID.suffix, pathText[bID.path], bID.suffix) < 0;
+    });
+
+    //Lay out the path and node tables.
+    CSRGraph* csr = new CSRGraph(memory);
+    csr->reserve(order.size(), getNumEdges());
+    csrPath[PathTrie::ROOT] = 0;
+    FlatHashMap<BFXNode*, uint32_t> index;
+    index.setResource(memory);
+    index.reserve(order.size());
+    for (BFXNode* curr : order){
+        const CompactID& ID = curr->getID();
+        if (csrPath[ID.path] == UINT32_MAX) csrPath[ID.path] = csr->addPath(pathText[ID.path]);
+        index.insert(curr, csr->addNode(csrPath[ID.path], ID.suffix, curr->getType(), curr->getName()));
+    }
+
+    //Stage the edges by node index.
+    for (size_t i = 0; i < NUM_SHARDS; i++){
+        FlatHashMap<EdgeKey, BFXEdge*, EdgeKeyHash>& edges = edgeShards[i].edges;
+        for (auto it = edges.begin(); it != edges.end(); it++){
+            BFXEdge* curr = it->second;
+            if (curr == nullptr) continue;
+
+            auto src = index.find(curr->getSource());
+            auto dst = index.find(curr->getDestination());
+            if (src == index.end() || dst == index.end()) continue;
+            csr->addEdge(src->second, dst->second, curr->getType(), curr->getCount());
+        }
+    }
+    csr->build();
+
+    //Symbols are only indexed while the graph is mutable.
+    if (linkAttributes || keepSymbols) collectSymbols();
+
+    //Release the mutable graph.
+    removeAllNodes();
+    for (size_t i = 0; i < NUM_SHARDS; i++){
+        edgeShards[i].pool.release();
+        nodeShards[i].pool.release();
+        mangleShards[i].IDs.clear();
+    }
+    frozen = csr;
 
     return true;
 }
 
+/**
+ * Checks whether the graph has been finalized.
+ * @return Boolean indicating whether the graph is frozen.
+ */
+bool TAGraph::isFrozen(){
+    return frozen != nullptr;
+}
+
+/**
+ * Gets the CSR layout of a finalized graph for traversal.
+ * @return The frozen graph (or nullptr if not finalized).
+ */
+const CSRGraph* TAGraph::getFrozenGraph(){
+    return frozen;
+}
+
 /**
  * Based on the TA standard, prints all instances of all
  * entities in the graph. Generates a string as per the
@@ -236,15 +427,49 @@ bool TAGraph::removeEdge(string srcID, string dstID, BFXEdge::EdgeType type) {
  * @return String with instances in TA format.
  */
 string TAGraph::printInstances() {
-    string instance = "";
+    TASink sink;
+    printInstances(sink);
+    return sink.release();
+}
 
-    //Iterate through the nodes and print their details.
-    for (auto it = nodeList.begin(); it != nodeList.end(); it++){
-        BFXNode* curr = it->second;
-        instance += INSTANCE_FLAG + " " + curr->getID() + " " + BFXNode::getTypeString(curr->getType()) + "\n";
+/**
+ * Based on the TA standard, prints all instances of all
+ * entities in the graph straight into a sink. Chunks of
+ * nodes are formatted in parallel and written in order.
+ * @param sink The sink to write to.
+ * @param numThreads The number of formatting threads.
+ */
+void TAGraph::printInstances(TASink& sink, int numThreads) {
+    //Scan the node table if we're frozen.
+    if (frozen != nullptr){
+        size_t numNodes = frozen->getNumNodes();
+        sink.writeChunks(numChunks(numNodes), [this, numNodes](size_t chunk, string& instance){
+            uint32_t last = (uint32_t) min(numNodes, (chunk + 1) * PRINT_CHUNK);
+            for (uint32_t i = (uint32_t) (chunk * PRINT_CHUNK); i < last; i++){
+                instance += INSTANCE_FLAG;
+                instance += ' ';
+                appendFrozenID(instance, i);
+                instance += ' ';
+                instance += BFXNode::getTypeString(frozen->getType(i));
+                instance += '\n';
+            }
+        }, numThreads);
+        return;
     }
 
-    return instance;
+    //Iterate through the nodes and print their details, a shard per chunk.
+    sink.writeChunks(NUM_SHARDS, [this](size_t chunk, string& instance){
+        FlatHashMap<CompactIDView, BFXNode*, CompactIDHash>& nodes = nodeShards[chunk].nodes;
+        for (auto it = nodes.begin(); it != nodes.end(); it++){
+            BFXNode* curr = it->second;
+            instance += INSTANCE_FLAG;
+            instance += ' ';
+            paths.appendID(instance, curr->getID().view());
+            instance += ' ';
+            instance += BFXNode::getTypeString(curr->getType());
+            instance += '\n';
+        }
+    }, numThreads);
 }
 
 /**
@@ -254,57 +479,579 @@ string TAGraph::printInstances() {
  * @return String with relationships in TA format.
  */
 string TAGraph::printRelationships() {
-    string relationships = "";
+    TASink sink;
+    printRelationships(sink);
+    return sink.release();
+}
 
-    //Iterate through the edges and print the details of each edge.
-    for (auto it = edgeList.begin(); it != edgeList.end(); it++){
-        BFXEdge* currEdge = it->second;
-        if (currEdge == nullptr) continue;
-        relationships += BFXEdge::getTypeString(currEdge->getType()) + " " + currEdge->getSrcID() + " " +
-                currEdge->getDstID() + "\n";
+/**
+ * Based on the TA standard, prints all edges in the graph
+ * straight into a sink. Chunks of source nodes are formatted
+ * in parallel and written in order.
+ * @param sink The sink to write to.
+ * @param numThreads The number of formatting threads.
+ */
+void TAGraph::printRelationships(TASink& sink, int numThreads) {
+    //Scan the forward arrays if we're frozen.
+    if (frozen != nullptr){
+        size_t numNodes = frozen->getNumNodes();
+        size_t perType = numChunks(numNodes);
+        sink.writeChunks(perType * CSRGraph::EDGE_TYPES, [this, numNodes, perType](size_t chunk, string& relationships){
+            BFXEdge::EdgeType type = (BFXEdge::EdgeType) (chunk / perType);
+            const string& label = BFXEdge::getTypeString(type);
+            uint32_t first = (uint32_t) ((chunk % perType) * PRINT_CHUNK);
+            uint32_t last = (uint32_t) min(numNodes, (size_t) first + PRINT_CHUNK);
+            for (uint32_t src = first; src < last; src++){
+                for (uint32_t dst : frozen->getOutEdges(src, type)){
+                    relationships += label;
+                    relationships += ' ';
+                    appendFrozenID(relationships, src);
+                    relationships += ' ';
+                    appendFrozenID(relationships, dst);
+                    relationships += '\n';
+                }
+            }
+        }, numThreads);
+        return;
     }
 
-    return relationships;
+    //Iterate through the edges and print the details of each edge.
+    sink.writeChunks(NUM_SHARDS, [this](size_t chunk, string& relationships){
+        FlatHashMap<EdgeKey, BFXEdge*, EdgeKeyHash>& edges = edgeShards[chunk].edges;
+        for (auto it = edges.begin(); it != edges.end(); it++){
+            BFXEdge* currEdge = it->second;
+            if (currEdge == nullptr) continue;
+            relationships += BFXEdge::getTypeString(currEdge->getType());
+            relationships += ' ';
+            paths.appendID(relationships, currEdge->getSrcID());
+            relationships += ' ';
+            paths.appendID(relationships, currEdge->getDstID());
+            relationships += '\n';
+        }
+    }, numThreads);
 }
 
 /**
  * Based on the TA standard, prints all nodes along with their attributes. This
  * includes their label. Does not print mangled name since this is for internal
- * use only.
+ * use only. Reference edges carry the number of references between the two
+ * symbols.
  * @return String with attributes in TA format.
  */
 string TAGraph::printAttributes(){
-    string attributes = "";
+    TASink sink;
+    printAttributes(sink);
+    return sink.release();
+}
 
-    //Iterate through the nodes and print their details.
-    for (auto it = nodeList.begin(); it != nodeList.end(); it++){
-        BFXNode* curr = it->second;
+/**
+ * Based on the TA standard, prints all node and reference
+ * attributes straight into a sink. Labels come first, then
+ * reference counts, each split into chunks that are formatted
+ * in parallel and written in order.
+ * @param sink The sink to write to.
+ * @param numThreads The number of formatting threads.
+ */
+void TAGraph::printAttributes(TASink& sink, int numThreads){
+    const string& refLabel = BFXEdge::getTypeString(BFXEdge::LINK);
+    if (linkAttributes) printLinkAttributes(sink);
+
+    //Scan the node table if we're frozen.
+    if (frozen != nullptr){
+        size_t numNodes = frozen->getNumNodes();
+        size_t perPass = numChunks(numNodes);
+
+        //With short IDs, each path is spelled out once, on the node it names.
+        vector<uint32_t> owners;
+        if (compactIDs){
+            owners.assign(frozen->getNumPaths(), NO_OWNER);
+            for (uint32_t i = 0; i < (uint32_t) numNodes; i++){
+                if (frozen->getSuffix(i).empty()) owners[frozen->getPath(i)] = i;
+            }
+        }
 
-        //Check if we have no label.
-        if (curr->getName().compare("") == 0) continue;
+        sink.writeChunks(perPass * 2, [this, &refLabel, &owners, numNodes, perPass](size_t chunk, string& attributes){
+            uint32_t first = (uint32_t) ((chunk % perPass) * PRINT_CHUNK);
+            uint32_t last = (uint32_t) min(numNodes, (size_t) first + PRINT_CHUNK);
+
+            //The first pass prints labels, and locations for short IDs.
+            if (chunk < perPass){
+                for (uint32_t i = first; i < last; i++){
+                    bool named = frozen->hasName(i);
+                    if (!named && !compactIDs) continue;
+
+                    appendFrozenID(attributes, i);
+                    attributes += " {";
+                    if (named){
+                        attributes += ' ';
+                        attributes += ATT_LABEL;
+                        attributes += " = \"";
+                        frozen->appendName(attributes, i);
+                        attributes += '"';
+                    }
+                    if (compactIDs) appendLocation(attributes, i, owners);
+                    attributes += " }\n";
+                }
+                return;
+            }
 
-        //Otherwise, we add an attribute entry.
-        attributes += curr->getID() + " { " + ATT_LABEL + " = \"" + curr->getName() + "\" }\n";
+            //The second pass prints reference counts.
+            for (uint32_t src = first; src < last; src++){
+                CSRGraph::Range dsts = frozen->getOutEdges(src, BFXEdge::LINK);
+                CSRGraph::Range counts = frozen->getOutCounts(src, BFXEdge::LINK);
+                for (size_t j = 0; j < dsts.size(); j++){
+                    attributes += '(';
+                    attributes += refLabel;
+                    attributes += ' ';
+                    appendFrozenID(attributes, src);
+                    attributes += ' ';
+                    appendFrozenID(attributes, dsts.first[j]);
+                    attributes += ") { ";
+                    attributes += ATT_REFS;
+                    attributes += " = ";
+                    TASink::appendNumber(attributes, counts.first[j]);
+                    attributes += " }\n";
+                }
+            }
+        }, numThreads);
+        return;
     }
 
-    return attributes;
+    //Labels come from the node shards, reference counts from the edge shards.
+    sink.writeChunks(NUM_SHARDS * 2, [this, &refLabel](size_t chunk, string& attributes){
+        if (chunk < NUM_SHARDS){
+            FlatHashMap<CompactIDView, BFXNode*, CompactIDHash>& nodes = nodeShards[chunk].nodes;
+            for (auto it = nodes.begin(); it != nodes.end(); it++){
+                BFXNode* curr = it->second;
+
+                //Check if we have no label.
+                if (curr->getName().empty()) continue;
+
+                //Otherwise, we add an attribute entry.
+                paths.appendID(attributes, curr->getID().view());
+                attributes += " { ";
+                attributes += ATT_LABEL;
+                attributes += " = \"";
+                attributes += curr->getName();
+                attributes += "\" }\n";
+            }
+            return;
+        }
+
+        //Add the reference counts.
+        FlatHashMap<EdgeKey, BFXEdge*, EdgeKeyHash>& edges = edgeShards[chunk - NUM_SHARDS].edges;
+        for (auto it = edges.begin(); it != edges.end(); it++){
+            BFXEdge* currEdge = it->second;
+            if (currEdge == nullptr || currEdge->getType() != BFXEdge::LINK) continue;
+
+            attributes += '(';
+            attributes += refLabel;
+            attributes += ' ';
+            paths.appendID(attributes, currEdge->getSrcID());
+            attributes += ' ';
+            paths.appendID(attributes, currEdge->getDstID());
+            attributes += ") { ";
+            attributes += ATT_REFS;
+            attributes += " = ";
+            TASink::appendNumber(attributes, currEdge->getCount());
+            attributes += " }\n";
+        }
+    }, numThreads);
+}
+
+/**
+ * Prints the instances of part of the frozen graph straight
+ * into a sink, in the order the whole graph is printed in.
+ * @param sink The sink to write to.
+ * @param nodes The node indices to print, in order.
+ * @param numThreads The number of formatting threads.
+ * @return Whether the graph is frozen.
+ */
+bool TAGraph::printSubgraphInstances(TASink& sink, const vector<uint32_t>& nodes, int numThreads){
+    if (frozen == nullptr) return false;
+
+    sink.writeChunks(numChunks(nodes.size()), [this, &nodes](size_t chunk, string& instances){
+        size_t last = min(nodes.size(), (chunk + 1) * PRINT_CHUNK);
+        for (size_t i = chunk * PRINT_CHUNK; i < last; i++){
+            instances += INSTANCE_FLAG;
+            instances += ' ';
+            appendFrozenID(instances, nodes[i]);
+            instances += ' ';
+            instances += BFXNode::getTypeString(frozen->getType(nodes[i]));
+            instances += '\n';
+        }
+    }, numThreads);
+    return true;
+}
+
+/**
+ * Prints the kept edges leaving part of the frozen graph
+ * straight into a sink, in the order the whole graph is
+ * printed in.
+ * @param sink The sink to write to.
+ * @param nodes The source node indices, in order.
+ * @param keepEdge Whether an edge from the first node to the second is printed.
+ * @param numThreads The number of formatting threads.
+ * @return Whether the graph is frozen.
+ */
+bool TAGraph::printSubgraphRelationships(TASink& sink, const vector<uint32_t>& nodes,
+                                         const function<bool(uint32_t, uint32_t)>& keepEdge, int numThreads){
+    if (frozen == nullptr) return false;
+
+    size_t perType = numChunks(nodes.size());
+    sink.writeChunks(perType * CSRGraph::EDGE_TYPES, [this, &nodes, &keepEdge, perType](size_t chunk, string& relationships){
+        BFXEdge::EdgeType type = (BFXEdge::EdgeType) (chunk / perType);
+        const string& label = BFXEdge::getTypeString(type);
+        size_t first = (chunk % perType) * PRINT_CHUNK;
+        size_t last = min(nodes.size(), first + PRINT_CHUNK);
+        for (size_t i = first; i < last; i++){
+            uint32_t src = nodes[i];
+            for (uint32_t dst : frozen->getOutEdges(src, type)){
+                if (!keepEdge(src, dst)) continue;
+                relationships += label;
+                relationships += ' ';
+                appendFrozenID(relationships, src);
+                relationships += ' ';
+                appendFrozenID(relationships, dst);
+                relationships += '\n';
+            }
+        }
+    }, numThreads);
+    return true;
+}
+
+/**
+ * Prints the labels of part of the frozen graph and the counts
+ * of the kept references leaving it straight into a sink. Labels
+ * come first, then reference counts.
+ * @param sink The sink to write to.
+ * @param nodes The node indices to print, in order.
+ * @param keepEdge Whether a reference from the first node to the second is printed.
+ * @param numThreads The number of formatting threads.
+ * @return Whether the graph is frozen.
+ */
+bool TAGraph::printSubgraphAttributes(TASink& sink, const vector<uint32_t>& nodes,
+                                      const function<bool(uint32_t, uint32_t)>& keepEdge, int numThreads){
+    if (frozen == nullptr) return false;
+
+    const string& refLabel = BFXEdge::getTypeString(BFXEdge::LINK);
+    size_t perPass = numChunks(nodes.size());
+    sink.writeChunks(perPass * 2, [this, &nodes, &keepEdge, &refLabel, perPass](size_t chunk, string& attributes){
+        size_t first = (chunk % perPass) * PRINT_CHUNK;
+        size_t last = min(nodes.size(), first + PRINT_CHUNK);
+
+        //The first pass prints labels.
+        if (chunk < perPass){
+            for (size_t i = first; i < last; i++){
+                if (!frozen->hasName(nodes[i])) continue;
+                appendFrozenID(attributes, nodes[i]);
+                attributes += " { ";
+                attributes += ATT_LABEL;
+                attributes += " = \"";
+                frozen->appendName(attributes, nodes[i]);
+                attributes += "\" }\n";
+            }
+            return;
+        }
+
+        //The second pass prints reference counts.
+        for (size_t i = first; i < last; i++){
+            uint32_t src = nodes[i];
+            CSRGraph::Range dsts = frozen->getOutEdges(src, BFXEdge::LINK);
+            CSRGraph::Range counts = frozen->getOutCounts(src, BFXEdge::LINK);
+            for (size_t j = 0; j < dsts.size(); j++){
+                if (!keepEdge(src, dsts.first[j])) continue;
+                attributes += '(';
+                attributes += refLabel;
+                attributes += ' ';
+                appendFrozenID(attributes, src);
+                attributes += ' ';
+                appendFrozenID(attributes, dsts.first[j]);
+                attributes += ") { ";
+                attributes += ATT_REFS;
+                attributes += " = ";
+                TASink::appendNumber(attributes, counts.first[j]);
+                attributes += " }\n";
+            }
+        }
+    }, numThreads);
+    return true;
+}
+
+/**
+ * Sets whether the frozen graph is printed with short IDs. Each
+ * node is named by a type letter and its index (e.g. f12) and
+ * its full path and section move into its attributes. Indices
+ * follow the sorted full IDs, so short IDs only repeat between
+ * runs over the same input. Graphs that aren't frozen always
+ * print full IDs.
+ * @param compact Whether to print short IDs.
+ */
+void TAGraph::setCompactIDs(bool compact){
+    compactIDs = compact;
+}
+
+/**
+ * Sets whether the graph keeps link attributes. Each node then
+ * lists the symbols it defines and the references made from it
+ * by name, so the TA file can be linked against others.
+ * @param link Whether to keep link attributes.
+ */
+void TAGraph::setLinkAttributes(bool link){
+    linkAttributes = link;
+}
+
+/**
+ * Gets whether the graph keeps link attributes.
+ * @return Whether link attributes are kept.
+ */
+bool TAGraph::hasLinkAttributes(){
+    return linkAttributes;
+}
+
+/**
+ * Records a reference by mangled name instead of linking it.
+ * The reference is kept on the node the source resolves to here
+ * and linked once every fragment's symbols are known. Nothing is
+ * kept unless link attributes are on.
+ * @param srcID The mangled name of the source.
+ * @param dstID The mangled name of the destination.
+ * @return Whether the reference was kept.
+ */
+bool TAGraph::addLink(string_view srcID, string_view dstID){
+    if (!linkAttributes || frozen != nullptr) return false;
+
+    CompactID src;
+    if (!findNodeIDByMangle(srcID, src)) return false;
+
+    string link;
+    link.reserve(srcID.size() + dstID.size() + 1);
+    link.append(srcID.data(), srcID.size());
+    link += LINK_SEPARATOR;
+    link.append(dstID.data(), dstID.size());
+
+    lock_guard<mutex> guard(linkLock);
+    links.push_back(make_pair(std::move(src), std::move(link)));
+    return true;
+}
+
+/**
+ * Sets whether the graph keeps its mangled names when it is
+ * finalized, so they can still be exported afterwards.
+ * @param keep Whether to keep mangled names.
+ */
+void TAGraph::setKeepSymbols(bool keep){
+    keepSymbols = keep;
+}
+
+/**
+ * Gets every mangled name with the full ID of the node defining
+ * it. A finalized graph only has them if they were kept.
+ * @return The node IDs and their mangled names.
+ */
+vector<pair<string, string>> TAGraph::getSymbols(){
+    if (frozen == nullptr) collectSymbols();
+
+    vector<pair<string, string>> named;
+    named.reserve(symbols.size());
+    for (const pair<CompactID, string>& entry : symbols){
+        named.push_back(make_pair(paths.getID(entry.first.view()), entry.second));
+    }
+    return named;
+}
+
+/**
+ * Gets the number of print chunks needed to cover a number
+ * of frozen nodes.
+ * @param numNodes The number of nodes.
+ * @return The number of chunks.
+ */
+size_t TAGraph::numChunks(size_t numNodes){
+    return (numNodes + PRINT_CHUNK - 1) / PRINT_CHUNK;
+}
+
+/**
+ * Appends the ID of a frozen node, short or in full.
+ * @param out The string to append to.
+ * @param node The node index.
+ */
+void TAGraph::appendFrozenID(string& out, uint32_t node) const {
+    if (!compactIDs){
+        frozen->appendID(out, node);
+        return;
+    }
+
+    out += BFXNode::getTypePrefix(frozen->getType(node));
+    TASink::appendNumber(out, node);
+}
+
+/**
+ * Appends the location attributes of a node printed with a
+ * short ID. A symbol points at the object file node holding
+ * its path, so the path is only written out on that node.
+ * @param out The string to append to.
+ * @param node The node index.
+ * @param owners The node named by each path, if any.
+ */
+void TAGraph::appendLocation(string& out, uint32_t node, const vector<uint32_t>& owners) const {
+    string_view suffix = frozen->getSuffix(node);
+    uint32_t path = frozen->getPath(node);
+
+    out += ' ';
+    if (!suffix.empty() && owners[path] != NO_OWNER){
+        out += ATT_OBJECT;
+        out += " = ";
+        appendFrozenID(out, owners[path]);
+    } else {
+        out += ATT_PATH;
+        out += " = \"";
+        frozen->appendPath(out, path);
+        out += '"';
+    }
+    if (suffix.empty()) return;
+
+    //Suffixes are a bracketed section and offset.
+    out += ' ';
+    out += ATT_SECTION;
+    out += " = \"";
+    out.append(suffix.data() + 1, suffix.size() - 2);
+    out += '"';
+}
+
+/**
+ * Copies every mangled name and the nodes defining it out of
+ * the mangle shards, dropping repeats and unnamed nodes.
+ */
+void TAGraph::collectSymbols(){
+    symbols.clear();
+    for (size_t i = 0; i < NUM_SHARDS; i++){
+        for (auto it = mangleShards[i].IDs.begin(); it != mangleShards[i].IDs.end(); it++){
+            if (it->first.empty()) continue;
+
+            const pmr::vector<CompactID>& IDs = it->second;
+            for (size_t j = 0; j < IDs.size(); j++){
+                bool repeat = false;
+                for (size_t k = 0; k < j && !repeat; k++) repeat = IDs[k].view() == IDs[j].view();
+                if (!repeat) symbols.push_back(make_pair(IDs[j], string(it->first)));
+            }
+        }
+    }
+}
+
+/**
+ * Prints the symbols attribute and the links attribute of every
+ * node that has them.
+ * @param sink The sink to write to.
+ */
+void TAGraph::printLinkAttributes(TASink& sink){
+    if (frozen == nullptr) collectSymbols();
+
+    string attributes;
+    appendLinkAttribute(attributes, symbols, ATT_SYMBOLS);
+    appendLinkAttribute(attributes, links, ATT_LINKS);
+    sink.append(attributes);
+}
+
+/**
+ * Appends one attribute line per node listing its symbols, in
+ * order. A symbol referenced several times is listed each time.
+ * @param out The string to append to.
+ * @param entries The nodes and their symbols.
+ * @param attribute The attribute name.
+ */
+void TAGraph::appendLinkAttribute(string& out, const vector<pair<CompactID, string>>& entries,
+                                  const string& attribute) const {
+    vector<pair<string, string_view>> named;
+    named.reserve(entries.size());
+    for (const pair<CompactID, string>& entry : entries){
+        named.push_back(make_pair(paths.getID(entry.first.view()), string_view(entry.second)));
+    }
+    sort(named.begin(), named.end());
+
+    for (size_t i = 0; i < named.size();){
+        out += named[i].first;
+        out += " { ";
+        out += attribute;
+        out += " = \"";
+
+        size_t j = i;
+        for (; j < named.size() && named[j].first == named[i].first; j++){
+            if (j != i) out += ' ';
+            out.append(named[j].second.data(), named[j].second.size());
+        }
+        out += "\" }\n";
+        i = j;
+    }
+}
+
+/**
+ * Sets the label of a node that already exists.
+ * @param ID The ID of the node.
+ * @param name The new label.
+ * @return Whether the node was found.
+ */
+bool TAGraph::setNodeName(string_view ID, string_view name){
+    if (frozen != nullptr) return false;
+
+    CompactIDView compactID;
+    if (!paths.lookup(ID, compactID)) return false;
+
+    NodeShard& shard = nodeShard(compactID);
+    lock_guard<mutex> guard(shard.lock);
+    auto it = shard.nodes.find(compactID);
+    if (it == shard.nodes.end() || it->second == nullptr) return false;
+
+    BFXNode* curr = it->second;
+    liveBytes += name.size();
+    liveBytes -= curr->getName().size();
+    curr->setName(name);
+    return true;
+}
+
+/**
+ * Raises the reference count of an edge to at least some value.
+ * Facts that are seen twice keep their count instead of doubling it.
+ * @param srcID The source ID.
+ * @param dstID The destination ID.
+ * @param type The edge type.
+ * @param count The count to raise it to.
+ * @return Whether the edge was found.
+ */
+bool TAGraph::raiseEdgeCount(string_view srcID, string_view dstID, BFXEdge::EdgeType type, uint32_t count){
+    if (frozen != nullptr) return false;
+
+    CompactIDView srcCompact, dstCompact;
+    if (!paths.lookup(srcID, srcCompact) || !paths.lookup(dstID, dstCompact)) return false;
+
+    EdgeKey key = {srcCompact, dstCompact, type};
+    EdgeShard& shard = edgeShard(key);
+    lock_guard<mutex> guard(shard.lock);
+    auto it = shard.edges.find(key);
+    if (it == shard.edges.end() || it->second == nullptr) return false;
+
+    if (it->second->getCount() < count) it->second->setCount(count);
+    return true;
 }
 
 /**
  * Checks whether an edge exists based on the source and destination
- * IDs.
+ * IDs. In low memory mode only edges since the last purge are seen;
+ * older duplicates are merged away when the TA file is written.
  * @param srcID The source ID
  * @param dstID The destination ID
  * @return Boolean indicating whether the edge was found.
  */
-bool TAGraph::doesContainEdgeExist(string srcID, string dstID){
-    if (lowMem) {
-        if (edgeBitList[srcID + dstID + BFXEdge::getTypeString(BFXEdge::CONTAINS)]) return true;
-        return false;
+bool TAGraph::doesContainEdgeExist(string_view srcID, string_view dstID){
+    if (frozen != nullptr){
+        uint32_t src, dst;
+        if (!frozen->findNode(srcID, src) || !frozen->findNode(dstID, dst)) return false;
+        return frozen->doesEdgeExist(src, dst, BFXEdge::CONTAINS);
     }
 
     //Check whether we can find edges of the type.
-    BFXEdge* results = findEdge(srcID, dstID, BFXEdge::CONTAINS);
+    CompactIDView src, dst;
+    if (!paths.lookup(srcID, src) || !paths.lookup(dstID, dst)) return false;
+    BFXEdge* results = findEdge(src, dst, BFXEdge::CONTAINS);
     if (results != nullptr) return true;
 
     return false;
@@ -312,30 +1059,34 @@ bool TAGraph::doesContainEdgeExist(string srcID, string dstID){
 
 /**
  * Checks whether an edge exists based on the source and destination
- * mangle values. Checks if ONE of the mangle values exist.
+ * mangle values. Checks if ONE of the mangle values exist. Both
+ * mangle shards stay locked while the node IDs are compared, so
+ * nothing is copied.
  * @param srcID Source mangled value.
  * @param dstID Destination mangle value.
  * @return
  */
-bool TAGraph::doesMangleEdgeExist(string srcID, string dstID){
+bool TAGraph::doesMangleEdgeExist(string_view srcID, string_view dstID){
+    MangleShard& srcShard = mangleShard(srcID);
+    MangleShard& dstShard = mangleShard(dstID);
+
+    //Lock both shards together (or once if they're the same).
+    unique_lock<mutex> srcLock(srcShard.lock, defer_lock);
+    unique_lock<mutex> dstLock(dstShard.lock, defer_lock);
+    if (&srcShard == &dstShard) srcLock.lock();
+    else std::lock(srcLock, dstLock);
+
     //Gets the mangled src and dst nodes.
-    vector<string> src = mangleList[srcID];
-    vector<string> dst = mangleList[dstID];
-    if (src.size() == 0 || dst.size() == 0) return false;
+    auto src = srcShard.IDs.find(srcID);
+    auto dst = dstShard.IDs.find(dstID);
+    if (src == srcShard.IDs.end() || dst == dstShard.IDs.end()) return false;
 
     //Searches for the edge.
-    for (auto curSrc : src){
-        for (auto curDst : dst){
-            //Check if we're low mem or not.
-            if (lowMem){
-                if (edgeBitList[curSrc + curDst + BFXEdge::getTypeString(BFXEdge::CONTAINS)] == true ||
-                    edgeBitList[curSrc + curDst + BFXEdge::getTypeString(BFXEdge::LINK)] == true)
-                    return true;
-            } else {
-                if (edgeList[curSrc + curDst + BFXEdge::getTypeString(BFXEdge::CONTAINS)] != nullptr ||
-                    edgeList[curSrc + curDst + BFXEdge::getTypeString(BFXEdge::LINK)] != nullptr)
-                    return true;
-            }
+    for (const CompactID& curSrc : src->second){
+        for (const CompactID& curDst : dst->second){
+            if (findEdge(curSrc.view(), curDst.view(), BFXEdge::CONTAINS) != nullptr ||
+                findEdge(curSrc.view(), curDst.view(), BFXEdge::LINK) != nullptr)
+                return true;
         }
     }
 
@@ -343,37 +1094,205 @@ bool TAGraph::doesMangleEdgeExist(string srcID, string dstID){
 }
 
 /**
- * Finds a node in the graph based on its ID.
+ * Checks whether a node exists.
  * @param ID The ID of the node.
+ * @return Boolean indicating whether the node exists.
+ */
+bool TAGraph::doesNodeExist(string_view ID){
+    if (frozen != nullptr){
+        uint32_t node;
+        return frozen->findNode(ID, node);
+    }
+    return IDExists(ID);
+}
+
+/**
+ * Finds the ID of the node a mangled name resolves to. If the
+ * name is defined more than once, the first ID in order wins.
+ * @param mangledName The mangled name.
+ * @param ID The ID of the node.
+ * @return Whether the name was found.
+ */
+bool TAGraph::findIDByMangle(string_view mangledName, string& ID){
+    CompactID compactID;
+    if (frozen != nullptr || !findNodeIDByMangle(mangledName, compactID)) return false;
+
+    ID = paths.getID(compactID.view());
+    return true;
+}
+
+/**
+ * Counts the edges of a type leaving a node.
+ * @param ID The node ID.
+ * @param type The edge type.
+ * @return The fan-out of the node.
+ */
+size_t TAGraph::getFanOut(string_view ID, BFXEdge::EdgeType type){
+    return getNeighbours(ID, type, true).size();
+}
+
+/**
+ * Counts the edges of a type entering a node.
+ * @param ID The node ID.
+ * @param type The edge type.
+ * @return The fan-in of the node.
+ */
+size_t TAGraph::getFanIn(string_view ID, BFXEdge::EdgeType type){
+    return getNeighbours(ID, type, false).size();
+}
+
+/**
+ * Gets the IDs of the nodes adjacent to a node over one
+ * edge type. Costs O(degree) in both the mutable and the
+ * frozen graph.
+ * @param ID The node ID.
+ * @param type The edge type.
+ * @param outgoing Whether to follow outgoing (or incoming) edges.
+ * @return The neighbour IDs.
+ */
+vector<string> TAGraph::getNeighbours(string_view ID, BFXEdge::EdgeType type, bool outgoing){
+    vector<string> neighbours;
+
+    //Use the CSR arrays if we're frozen.
+    if (frozen != nullptr){
+        uint32_t node;
+        if (!frozen->findNode(ID, node)) return neighbours;
+
+        CSRGraph::Range range = (outgoing) ? frozen->getOutEdges(node, type) : frozen->getInEdges(node, type);
+        for (uint32_t curr : range) neighbours.push_back(frozen->getID(curr));
+        return neighbours;
+    }
+
+    CompactIDView compactID;
+    if (!paths.lookup(ID, compactID)) return neighbours;
+    NodeShard& shard = nodeShard(compactID);
+    lock_guard<mutex> guard(shard.lock);
+    auto it = shard.nodes.find(compactID);
+    if (it == shard.nodes.end() || it->second == nullptr) return neighbours;
+
+    const pmr::vector<BFXEdge*>& edges = (outgoing) ? it->second->getOutEdges() : it->second->getInEdges();
+    for (BFXEdge* edge : edges){
+        if (edge->getType() != type) continue;
+        neighbours.push_back(paths.getID((outgoing) ? edge->getDstID() : edge->getSrcID()));
+    }
+    return neighbours;
+}
+
+/**
+ * Picks the shard for a key hash. The hash is mixed the same
+ * way the flat maps mix it, so the shard comes from the top bits;
+ * the low bits are the control bits inside the shard's map and
+ * must still vary between the keys of one shard.
+ * @param hash The hash of the node ID, edge key or mangled name.
+ * @return The shard index.
+ */
+size_t TAGraph::shardOf(size_t hash){
+    uint64_t h = (uint64_t) hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t) (h >> (64 - SHARD_BITS));
+}
+
+/**
+ * Gets the shard that holds a node.
+ * @param ID The node ID.
+ * @return The node shard.
+ */
+TAGraph::NodeShard& TAGraph::nodeShard(const CompactIDView& ID){
+    return nodeShards[shardOf(CompactIDHash()(ID))];
+}
+
+/**
+ * Gets the shard that holds an edge.
+ * @param key The edge key.
+ * @return The edge shard.
+ */
+TAGraph::EdgeShard& TAGraph::edgeShard(const EdgeKey& key){
+    return edgeShards[shardOf(EdgeKeyHash()(key))];
+}
+
+/**
+ * Gets the shard that holds a mangled name.
+ * @param mangle The mangled name.
+ * @return The mangle shard.
+ */
+TAGraph::MangleShard& TAGraph::mangleShard(string_view mangle){
+    return mangleShards[shardOf(std::hash<string_view>()(mangle))];
+}
+
+/**
+ * Counts the edges over all shards.
+ * @return The number of edges.
+ */
+size_t TAGraph::getNumEdges(){
+    size_t total = 0;
+    for (size_t i = 0; i < NUM_SHARDS; i++) total += edgeShards[i].edges.size();
+    return total;
+}
+
+/**
+ * Finds a node in the graph based on its ID.
+ * @param ID The compact ID of the node.
  * @return A pointer to the BFXNode.
  */
-BFXNode* TAGraph::findNode(std::string ID){
-    //Iterate through and search.
-    return nodeList[ID];
+BFXNode* TAGraph::findNode(const CompactIDView& ID){
+    NodeShard& shard = nodeShard(ID);
+    lock_guard<mutex> guard(shard.lock);
+
+    auto it = shard.nodes.find(ID);
+    return (it == shard.nodes.end()) ? nullptr : it->second;
 }
 
-string TAGraph::findNodeIDByMangle(string mangle){
-    //Goes through the mangle list.
-    vector<string> nodeIDs = mangleList[mangle];
-    if (nodeIDs.size() == 0) return string();
+/**
+ * Finds the ID of a node based on its mangle value. When several
+ * nodes share the mangled name the smallest ID wins, so the result
+ * doesn't depend on the order files were processed in.
+ * @param mangle The mangle value of the node.
+ * @param ID The compact ID of the node, if found.
+ * @return Boolean indicating whether the mangled name was found.
+ */
+bool TAGraph::findNodeIDByMangle(string_view mangle, CompactID& ID){
+    MangleShard& shard = mangleShard(mangle);
+    lock_guard<mutex> guard(shard.lock);
 
-    //TODO: What should we return if there is more than one?
-    return nodeIDs.at(0);
+    //Goes through the mangle list.
+    auto it = shard.IDs.find(mangle);
+    if (it == shard.IDs.end() || it->second.size() == 0) return false;
+    ID = firstID(it->second);
+    return true;
 }
 
 /**
- * Finds a node in the graph based on its mangle
- * value.
+ * Finds a node in the graph based on its mangle value. Picks
+ * the same node as findNodeIDByMangle without copying the ID.
+ * The node lookup happens under the mangle lock; mangle locks
+ * may be held while taking node or edge locks, never the reverse.
  * @param mangle The mangle value of the node.
  * @return A pointer to the BFXNode.
  */
-BFXNode* TAGraph::findNodeByMangle(string mangle){
+BFXNode* TAGraph::findNodeByMangle(string_view mangle){
+    MangleShard& shard = mangleShard(mangle);
+    lock_guard<mutex> guard(shard.lock);
+
     //Goes through the mangle list.
-    vector<string> nodeIDs = mangleList[mangle];
-    if (nodeIDs.size() == 0) return nullptr;
+    auto it = shard.IDs.find(mangle);
+    if (it == shard.IDs.end() || it->second.size() == 0) return nullptr;
+    return findNode(firstID(it->second).view());
+}
 
-    //TODO: What should we return if there is more than one?
-    return nodeList[nodeIDs.at(0)];
+/**
+ * Gets the ID that sorts first in a mangle list. Full IDs are
+ * only rebuilt when the list holds IDs on different paths.
+ * @param IDs The non-empty list of IDs.
+ * @return The smallest ID.
+ */
+const CompactID& TAGraph::firstID(const pmr::vector<CompactID>& IDs){
+    const CompactID* first = &IDs[0];
+    for (size_t i = 1; i < IDs.size(); i++){
+        if (paths.compare(IDs[i].view(), first->view()) < 0) first = &IDs[i];
+    }
+    return *first;
 }
 
 /**
@@ -383,10 +1302,14 @@ BFXNode* TAGraph::findNodeByMangle(string mangle){
  * @param type The type of edge. (See BFXEdge)
  * @return A pointers to the found edge (or nullptr).
  */
-BFXEdge* TAGraph::findEdge(string src, string dst, BFXEdge::EdgeType type) {
-    //Gets the edge.
-    BFXEdge* edge = edgeList[src + dst + BFXEdge::getTypeString(type)];
-    return edge;
+BFXEdge* TAGraph::findEdge(const CompactIDView& src, const CompactIDView& dst, BFXEdge::EdgeType type) {
+    EdgeKey key = {src, dst, type};
+    EdgeShard& shard = edgeShard(key);
+    lock_guard<mutex> guard(shard.lock);
+
+    //Gets the edge without inserting an empty entry.
+    auto it = shard.edges.find(key);
+    return (it == shard.edges.end()) ? nullptr : it->second;
 }
 
 /**
@@ -394,34 +1317,241 @@ BFXEdge* TAGraph::findEdge(string src, string dst, BFXEdge::EdgeType type) {
  * @param ID The ID to look for.
  * @return Boolean indicating whether the node was found.
  */
-bool TAGraph::IDExists(std::string ID){
-    if (lowMem) return nodeBitList[ID];
+bool TAGraph::IDExists(string_view ID){
+    CompactIDView compactID;
+    if (!paths.lookup(ID, compactID)) return false;
+    if (lowMem) return nodeExists(ID, compactID);
 
-    if (findNode(ID) == nullptr)
+    if (findNode(compactID) == nullptr)
         return false;
 
     return true;
 }
 
 /**
- * Removes all edges based on some particular ID.
- * @param ID The ID to remove all edges by.
+ * Checks whether a node exists in low memory mode. Live nodes
+ * are checked exactly, then the filter rules out nodes that were
+ * never added. A filter hit is confirmed against the spilled
+ * instances without holding the filter lock, so other threads
+ * aren't held up by the disk reads.
+ * @param ID The ID to look for.
+ * @param compactID The same ID split on the path trie.
+ * @return Boolean indicating whether the node exists.
  */
-void TAGraph::removeAllEdges(std::string ID){
-    //Iterate through edge list and delete edges that match.
-    for (auto it = edgeList.begin(); it != edgeList.end(); it++){
-        BFXEdge* current = it->second;
-        if (current == nullptr) continue;
+bool TAGraph::nodeExists(string_view ID, const CompactIDView& compactID){
+    if (findNode(compactID) != nullptr) return true;
+
+    function<bool(string_view)> lookup;
+    {
+        lock_guard<mutex> guard(filterLock);
+        if (!nodeFilter.mayContain(ID)) return false;
+        if (!spillLookup) return true;
+
+        //Check recent confirmations before going to disk.
+        if (confirmed.count(ID) != 0) return true;
+        lookup = spillLookup;
+    }
+    if (!lookup(ID)) return false;
 
-        //Checks if the edge is a source or destination.
-        if (current->getSrcID().compare(ID) == 0 ||
-                current->getDstID().compare(ID) == 0){
-            BFXEdge* edge =
-                    edgeList[current->getSrcID() + current->getDstID() + BFXEdge::getTypeString(current->getType())];
+    lock_guard<mutex> guard(filterLock);
+    if (confirmed.size() >= CONFIRM_CACHE) confirmed.clear();
+    confirmed.insert(string(ID), true);
+    return true;
+}
+
+/**
+ * Sets the lookup used to confirm filter hits against spilled
+ * nodes in low memory mode.
+ * @param lookup Function that checks the spilled instances for an ID.
+ */
+void TAGraph::setSpillLookup(function<bool(string_view)> lookup){
+    lock_guard<mutex> guard(filterLock);
+    spillLookup = lookup;
+}
+
+/**
+ * Estimates the bytes a purge would free: the nodes and edges
+ * held while the graph is being built. Safe to call while other
+ * threads insert.
+ * @return The estimated purgeable memory use.
+ */
+size_t TAGraph::getLiveBytes(){
+    return liveBytes;
+}
 
-            //Set nullptr on the edge.
-            it = edgeList.erase(it);
-            delete edge;
+/**
+ * Estimates the bytes that survive purges: the mangle list and
+ * the node filter. Safe to call while other threads insert.
+ * @return The estimated memory use that can't be purged.
+ */
+size_t TAGraph::getRetainedBytes(){
+    lock_guard<mutex> guard(filterLock);
+    return retainedBytes + nodeFilter.getMemoryBytes();
+}
+
+/**
+ * Records a node ID under a mangled name.
+ * @param mangle The mangled name.
+ * @param ID The compact node ID.
+ */
+void TAGraph::addMangle(const string& mangle, const CompactID& ID){
+    MangleShard& shard = mangleShard(mangle);
+    lock_guard<mutex> guard(shard.lock);
+
+    auto it = shard.IDs.find(mangle);
+    if (it == shard.IDs.end()){
+        it = shard.IDs.insert(pmr::string(mangle, memory), pmr::vector<CompactID>(memory)).first;
+        retainedBytes += sizeof(string) + sizeof(vector<CompactID>) + mangle.size() + 1;
+    }
+    if (!it->second.empty() && it->second.back().view() == ID.view()) return;
+    it->second.push_back(CompactID{ID.path, pmr::string(ID.suffix, memory)});
+    retainedBytes += sizeof(CompactID) + ID.suffix.size();
+}
+
+/**
+ * Creates and indexes an edge unless another thread got there
+ * first. The check and insert happen under the edge shard lock.
+ * The stored key views the new edge's own endpoint IDs.
+ * @param srcID The source ID.
+ * @param dstID The destination ID.
+ * @param src The source node (or nullptr to link by ID).
+ * @param dst The destination node (or nullptr to link by ID).
+ * @param type The edge type.
+ * @param count Whether an existing edge has its count bumped.
+ */
+void TAGraph::insertEdge(const CompactIDView& srcID, const CompactIDView& dstID, BFXNode* src, BFXNode* dst,
+                         BFXEdge::EdgeType type, bool count){
+    EdgeKey key = {srcID, dstID, type};
+    EdgeShard& shard = edgeShard(key);
+    BFXEdge* edge;
+
+    {
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.edges.find(key);
+        if (it != shard.edges.end()){
+            if (count) it->second->incrementCount();
+            return;
         }
+
+        edge = (src != nullptr && dst != nullptr) ? shard.pool.create(src, dst, type) :
+               shard.pool.create(srcID, dstID, type, memory);
+        EdgeKey stored = {edge->getSrcID(), edge->getDstID(), type};
+        shard.edges.insert(stored, edge);
+    }
+    liveBytes += edgeBytes(edge);
+
+    attachEdge(edge);
+}
+
+/**
+ * Removes all edges touching a node. Walks the node's own
+ * adjacency lists so the cost is O(degree).
+ * @param node The node to remove all edges from.
+ */
+void TAGraph::removeAllEdges(BFXNode* node){
+    //Copy the lists since detaching edits them.
+    vector<BFXEdge*> edges(node->getOutEdges().begin(), node->getOutEdges().end());
+    edges.insert(edges.end(), node->getInEdges().begin(), node->getInEdges().end());
+
+    for (BFXEdge* edge : edges){
+        //Self loops appear in both lists.
+        EdgeKey key = {edge->getSrcID(), edge->getDstID(), edge->getType()};
+        EdgeShard& shard = edgeShard(key);
+        auto it = shard.edges.find(key);
+        if (it == shard.edges.end() || it->second != edge) continue;
+
+        shard.edges.erase(it);
+        detachEdge(edge);
+        liveBytes -= min(edgeBytes(edge), liveBytes.load());
+        shard.pool.destroy(edge);
+    }
+}
+
+/**
+ * Records a new edge on the adjacency lists of whichever
+ * endpoints are still in memory. Each list is edited under
+ * its own node shard lock, one lock at a time.
+ * @param edge The new edge.
+ */
+void TAGraph::attachEdge(BFXEdge* edge){
+    NodeShard& srcShard = nodeShard(edge->getSrcID());
+    {
+        lock_guard<mutex> guard(srcShard.lock);
+        BFXNode* src = edgeSource(edge);
+        if (src != nullptr) src->addOutEdge(edge);
+    }
+
+    NodeShard& dstShard = nodeShard(edge->getDstID());
+    {
+        lock_guard<mutex> guard(dstShard.lock);
+        BFXNode* dst = edgeDestination(edge);
+        if (dst != nullptr) dst->addInEdge(edge);
+    }
+}
+
+/**
+ * Removes an edge from the adjacency lists of its endpoints.
+ * @param edge The edge to unhook.
+ */
+void TAGraph::detachEdge(BFXEdge* edge){
+    BFXNode* src = edgeSource(edge);
+    BFXNode* dst = edgeDestination(edge);
+    if (src != nullptr) src->removeOutEdge(edge);
+    if (dst != nullptr) dst->removeInEdge(edge);
+}
+
+/**
+ * Gets the live source node of an edge. Low memory edges
+ * only carry IDs so the node is looked up. The caller holds
+ * the node shard lock when other threads are inserting.
+ * @param edge The edge.
+ * @return The source node (or nullptr if purged).
+ */
+BFXNode* TAGraph::edgeSource(BFXEdge* edge){
+    if (edge->getSource() != nullptr) return edge->getSource();
+
+    NodeShard& shard = nodeShard(edge->getSrcID());
+    auto it = shard.nodes.find(edge->getSrcID());
+    return (it == shard.nodes.end()) ? nullptr : it->second;
+}
+
+/**
+ * Gets the live destination node of an edge.
+ * @param edge The edge.
+ * @return The destination node (or nullptr if purged).
+ */
+BFXNode* TAGraph::edgeDestination(BFXEdge* edge){
+    if (edge->getDestination() != nullptr) return edge->getDestination();
+
+    NodeShard& shard = nodeShard(edge->getDstID());
+    auto it = shard.nodes.find(edge->getDstID());
+    return (it == shard.nodes.end()) ? nullptr : it->second;
+}
+
+/**
+ * Estimates the bytes held by a node and its index entry.
+ * @param node The node.
+ * @return The estimated size.
+ */
+size_t TAGraph::nodeBytes(const BFXNode* node){
+    size_t bytes = sizeof(BFXNode) + sizeof(CompactIDView) + sizeof(BFXNode*) + 1;
+    bytes += node->getID().suffix.size() + node->getName().size();
+    for (string_view mangle : node->getMangledNames()) bytes += sizeof(pmr::string) + mangle.size();
+    return bytes;
+}
+
+/**
+ * Estimates the bytes held by an edge, its index entry and its
+ * place in the adjacency lists.
+ * @param edge The edge.
+ * @return The estimated size.
+ */
+size_t TAGraph::edgeBytes(const BFXEdge* edge){
+    size_t bytes = sizeof(BFXEdge) + sizeof(EdgeKey) + 3 * sizeof(BFXEdge*) + 1;
+
+    //Low memory edges own their endpoint IDs.
+    if (edge->getSource() == nullptr){
+        bytes += 2 * sizeof(CompactID) + edge->getSrcID().suffix.size() + edge->getDstID().suffix.size();
     }
-}
\ No newline at end of file
+    return bytes;
+}
@@ -28,56 +28,220 @@
 #ifndef BFX64_TAGRAPH_H
 #define BFX64_TAGRAPH_H
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
-#include <bits/unordered_map.h>
 #include "BFXNode.h"
 #include "BFXEdge.h"
+#include "CSRGraph.h"
+#include "ObjectPool.h"
+#include "FlatHashMap.h"
+#include "BloomFilter.h"
+#include "PathTrie.h"
+#include "MappedArena.h"
+#include "TASink.h"
 
+/**
+ * Node, edge and mangle indexes are split into shards by key
+ * hash, each with its own lock. addNode, addEdge, addEdgeByMangle
+ * and the lookup methods may be called from many threads at once.
+ * Removal, freezing and printing need the graph to themselves.
+ * Lookups take string views, never insert into the indexes and
+ * don't allocate. IDs are stored as a path trie node plus a
+ * suffix and only rebuilt in full when printed. With a mapped
+ * arena, node and edge records, their ID suffixes and names, the
+ * node, edge and mangle indexes, the path trie and the frozen graph
+ * live in a file mapping instead of the heap. Only the low memory
+ * Bloom filter and the link attribute lists stay on the heap.
+ */
 class TAGraph {
 public:
     /** Constructor / Destructor */
-    TAGraph(bool lowMemory = false);
+    TAGraph(bool lowMemory = false, MappedArena* storage = nullptr);
+    TAGraph(CSRGraph* frozenGraph);
     ~TAGraph();
 
+    /** Sizing Operations */
+    void reserve(size_t numNodes, size_t numEdges, size_t numMangles);
+
     /** Node Operations */
     bool addNode(std::string ID, BFXNode::NodeType type, std::string name, std::string mangledName);
-    bool removeNode(std::string ID);
+    bool addAlias(std::string_view ID, const std::string& mangledName);
+    bool removeNode(std::string_view ID);
     bool removeAllNodes();
+    bool setNodeName(std::string_view ID, std::string_view name);
 
     /** Edge Operations */
-    bool addEdge(std::string srcID, std::string dstID, BFXEdge::EdgeType type);
-    bool addEdgeByMangle(std::string srcID, std::string dstID, BFXEdge::EdgeType type);
-    bool removeEdge(std::string srcID, std::string dstID, BFXEdge::EdgeType type);
+    bool addEdge(std::string_view srcID, std::string_view dstID, BFXEdge::EdgeType type);
+    bool addEdgeByMangle(std::string_view srcID, std::string_view dstID, BFXEdge::EdgeType type);
+    bool removeEdge(std::string_view srcID, std::string_view dstID, BFXEdge::EdgeType type);
+    bool raiseEdgeCount(std::string_view srcID, std::string_view dstID, BFXEdge::EdgeType type, uint32_t count);
+
+    /** Freeze Operations */
+    bool finalize();
+    bool isFrozen();
+    const CSRGraph* getFrozenGraph();
 
     /** TA Generation Operations */
     std::string printInstances();
     std::string printRelationships();
     std::string printAttributes();
+    void printInstances(TASink& sink, int numThreads = 1);
+    void printRelationships(TASink& sink, int numThreads = 1);
+    void printAttributes(TASink& sink, int numThreads = 1);
+    void setCompactIDs(bool compact);
+    bool printSubgraphInstances(TASink& sink, const std::vector<uint32_t>& nodes, int numThreads = 1);
+    bool printSubgraphRelationships(TASink& sink, const std::vector<uint32_t>& nodes,
+                                    const std::function<bool(uint32_t, uint32_t)>& keepEdge, int numThreads = 1);
+    bool printSubgraphAttributes(TASink& sink, const std::vector<uint32_t>& nodes,
+                                 const std::function<bool(uint32_t, uint32_t)>& keepEdge, int numThreads = 1);
+
+    /** Link Attribute Operations */
+    void setLinkAttributes(bool link);
+    bool hasLinkAttributes();
+    bool addLink(std::string_view srcID, std::string_view dstID);
+
+    /** Symbol Operations */
+    void setKeepSymbols(bool keep);
+    std::vector<std::pair<std::string, std::string>> getSymbols();
+
+    /** Link Attribute Format (Source, Separator, Destination) */
+    static const char LINK_SEPARATOR = '>';
+
+    /** Adjacency Queries */
+    size_t getFanOut(std::string_view ID, BFXEdge::EdgeType type);
+    size_t getFanIn(std::string_view ID, BFXEdge::EdgeType type);
+    std::vector<std::string> getNeighbours(std::string_view ID, BFXEdge::EdgeType type, bool outgoing);
+
+    /** Low Memory Operations */
+    void setSpillLookup(std::function<bool(std::string_view)> lookup);
+    size_t getLiveBytes();
+    size_t getRetainedBytes();
 
     /** Find Methods */
-    bool doesContainEdgeExist(std::string srcID, std::string dstID);
-    bool doesMangleEdgeExist(std::string srcID, std::string dstID);
+    bool doesContainEdgeExist(std::string_view srcID, std::string_view dstID);
+    bool doesMangleEdgeExist(std::string_view srcID, std::string_view dstID);
+    bool doesNodeExist(std::string_view ID);
+    bool findIDByMangle(std::string_view mangledName, std::string& ID);
 private:
-    /** Private Variables */
-    std::unordered_map<std::string, BFXNode*> nodeList;
-    std::unordered_map<std::string, BFXEdge*> edgeList;
-    std::unordered_map<std::string, std::vector<std::string>> mangleList;
-    std::unordered_map<std::string, bool> nodeBitList;
-    std::unordered_map<std::string, bool> edgeBitList;
+    /** Edge Key (Views Into the Edge's Own Endpoint IDs) */
+    struct EdgeKey {
+        CompactIDView src;
+        CompactIDView dst;
+        BFXEdge::EdgeType type;
+
+        bool operator==(const EdgeKey& other) const {
+            return type == other.type && src == other.src && dst == other.dst;
+        }
+    };
+    struct EdgeKeyHash {
+        size_t operator()(const EdgeKey& key) const {
+            size_t h = CompactIDHash()(key.src);
+            h ^= CompactIDHash()(key.dst) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            return h ^ (size_t) key.type;
+        }
+    };
+
+    /** Shard Sizing */
+    static const int SHARD_BITS = 6;
+    static const size_t NUM_SHARDS = (size_t) 1 << SHARD_BITS;
+    static const size_t SHARD_CHUNK = 512;
+
+    /** Frozen Nodes per Print Chunk */
+    static const size_t PRINT_CHUNK = 4096;
+
+    /** Index Shards (Node Keys View the Node's Own ID) */
+    struct NodeShard {
+        std::mutex lock;
+        FlatHashMap<CompactIDView, BFXNode*, CompactIDHash> nodes;
+        ObjectPool<BFXNode> pool;
+        NodeShard() : pool(SHARD_CHUNK) { }
+    };
+    struct EdgeShard {
+        std::mutex lock;
+        FlatHashMap<EdgeKey, BFXEdge*, EdgeKeyHash> edges;
+        ObjectPool<BFXEdge> pool;
+        EdgeShard() : pool(SHARD_CHUNK) { }
+    };
+    struct MangleShard {
+        std::mutex lock;
+        FlatHashMap<std::pmr::string, std::pmr::vector<CompactID>, StringHash, StringEqual> IDs;
+    };
+
+    /** Private Variables (Storage Outlives the Shards) */
+    std::unique_ptr<MappedArena> storage;
+    std::pmr::memory_resource* memory = std::pmr::new_delete_resource();
+    PathTrie paths;
+    NodeShard nodeShards[NUM_SHARDS];
+    EdgeShard edgeShards[NUM_SHARDS];
+    MangleShard mangleShards[NUM_SHARDS];
+    std::mutex filterLock;
+    BloomFilter nodeFilter;
+    FlatHashMap<std::string, bool, StringHash, StringEqual> confirmed;
+    std::function<bool(std::string_view)> spillLookup;
+    CSRGraph* frozen = nullptr;
+
+    /** Defined Symbols and References by Name (Kept for Link Attributes or Export) */
+    std::mutex linkLock;
+    std::vector<std::pair<CompactID, std::string>> symbols;
+    std::vector<std::pair<CompactID, std::string>> links;
+
+    /** Estimated Bytes Held (Purgeable and Kept Across Purges) */
+    std::atomic<size_t> liveBytes{0};
+    std::atomic<size_t> retainedBytes{0};
 
     bool lowMem = false;
+    bool compactIDs = false;
+    bool linkAttributes = false;
+    bool keepSymbols = false;
     const std::string INSTANCE_FLAG = "$INSTANCE";
     const std::string ATT_LABEL = "label";
+    const std::string ATT_REFS = "refs";
+    const std::string ATT_PATH = "path";
+    const std::string ATT_OBJECT = "object";
+    const std::string ATT_SECTION = "section";
+    const std::string ATT_SYMBOLS = "symbols";
+    const std::string ATT_LINKS = "links";
+    static const uint32_t NO_OWNER = UINT32_MAX;
+    const size_t CONFIRM_CACHE = 4096;
+
+    /** Shard Methods */
+    static size_t shardOf(size_t hash);
+    NodeShard& nodeShard(const CompactIDView& ID);
+    EdgeShard& edgeShard(const EdgeKey& key);
+    MangleShard& mangleShard(std::string_view mangle);
+    size_t getNumEdges();
+    static size_t numChunks(size_t numNodes);
+    void appendFrozenID(std::string& out, uint32_t node) const;
+    void appendLocation(std::string& out, uint32_t node, const std::vector<uint32_t>& owners) const;
+    void collectSymbols();
+    void printLinkAttributes(TASink& sink);
+    void appendLinkAttribute(std::string& out, const std::vector<std::pair<CompactID, std::string>>& entries,
+                             const std::string& attribute) const;
 
     /** Helper Methods */
-    BFXNode* findNode(std::string ID);
-    std::string findNodeIDByMangle(std::string mangle);
-    BFXNode* findNodeByMangle(std::string mangle);
-    BFXEdge* findEdge(std::string src, std::string dst, BFXEdge::EdgeType type);
-    bool IDExists(std::string ID);
-    void removeAllEdges(std::string ID);
+    BFXNode* findNode(const CompactIDView& ID);
+    bool findNodeIDByMangle(std::string_view mangle, CompactID& ID);
+    BFXNode* findNodeByMangle(std::string_view mangle);
+    const CompactID& firstID(const std::pmr::vector<CompactID>& IDs);
+    BFXEdge* findEdge(const CompactIDView& src, const CompactIDView& dst, BFXEdge::EdgeType type);
+    bool IDExists(std::string_view ID);
+    bool nodeExists(std::string_view ID, const CompactIDView& compactID);
+    void addMangle(const std::string& mangle, const CompactID& ID);
+    void insertEdge(const CompactIDView& srcID, const CompactIDView& dstID, BFXNode* src, BFXNode* dst,
+                    BFXEdge::EdgeType type, bool count);
+    void removeAllEdges(BFXNode* node);
+    void attachEdge(BFXEdge* edge);
+    void detachEdge(BFXEdge* edge);
+    BFXNode* edgeSource(BFXEdge* edge);
+    BFXNode* edgeDestination(BFXEdge* edge);
+    static size_t nodeBytes(const BFXNode* node);
+    static size_t edgeBytes(const BFXEdge* edge);
 };
 
 #endif //BFX64_TAGRAPH_H
@@ -0,0 +1,247 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TASink.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Buffered sink for TA output. The graph appends each line straight
+// into a large buffer that is written out whenever it fills, so a
+// TA section is never built up in memory as a whole.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TASink.h"
+
+using namespace std;
+
+const size_t TASink::DEFAULT_CAPACITY = 4 * 1024 * 1024;
+
+/**
+ * Creates a sink that collects everything in memory.
+ */
+TASink::TASink(){
+    this->out = nullptr;
+    this->capacity = 0;
+    this->failed = false;
+}
+
+/**
+ * Creates a sink that writes to a stream in large blocks.
+ * @param out The stream to write to.
+ * @param capacity The number of bytes buffered before a write.
+ */
+TASink::TASink(ostream& out, size_t capacity){
+    this->out = &out;
+    this->capacity = capacity;
+    this->failed = false;
+
+    //Leave room for the line that crosses the limit.
+    data.reserve(capacity + capacity / 16);
+}
+
+/**
+ * Creates a sink that hands its buffer to a consumer whenever
+ * it fills. The buffer always ends on a whole line.
+ * @param consumer Function that takes a full buffer.
+ * @param capacity The number of bytes buffered before a hand-off.
+ */
+TASink::TASink(function<bool(const string&)> consumer, size_t capacity){
+    this->out = nullptr;
+    this->consumer = consumer;
+    this->capacity = capacity;
+    this->failed = false;
+
+    data.reserve(capacity + capacity / 16);
+}
+
+/**
+ * Destructor. Writes out whatever is left.
+ */
+TASink::~TASink(){
+    flush();
+}
+
+/**
+ * Gets the buffer to append the current line to. The line
+ * should be committed once it is complete.
+ * @return The buffer.
+ */
+string& TASink::buffer(){
+    return data;
+}
+
+/**
+ * Appends text to the current line.
+ * @param text The text to append.
+ */
+void TASink::append(string_view text){
+    data.append(text.data(), text.size());
+}
+
+/**
+ * Appends a number to the current line without building
+ * a temporary string.
+ * @param value The number to append.
+ */
+void TASink::appendNumber(uint64_t value){
+    appendNumber(data, value);
+}
+
+/**
+ * Appends a number to a string without building a
+ * temporary string.
+ * @param out The string to append to.
+ * @param value The number to append.
+ */
+void TASink::appendNumber(string& out, uint64_t value){
+    char digits[24];
+    to_chars_result result = to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, (size_t) (result.ptr - digits));
+}
+
+/**
+ * Marks the end of a line. Writes the buffer out once it
+ * has filled up.
+ */
+void TASink::commit(){
+    if ((out != nullptr || consumer) && data.size() >= capacity) flush();
+}
+
+/**
+ * Writes the buffer to the stream.
+ * @return Whether everything written so far succeeded.
+ */
+bool TASink::flush(){
+    if (out == nullptr && !consumer) return true;
+
+    if (!data.empty()){
+        if (out != nullptr){
+            out->write(data.data(), (streamsize) data.size());
+            if (out->fail()) failed = true;
+        } else if (!consumer(data)){
+            failed = true;
+        }
+        data.clear();
+    }
+    return !failed;
+}
+
+/**
+ * Formats a sequence of chunks and appends them in order. Worker
+ * threads format chunks into their own buffers while this thread
+ * appends finished chunks, so the output matches a serial run.
+ * Only a few chunks per thread are in flight at once.
+ * @param numChunks The number of chunks.
+ * @param format Function that appends a chunk to a string.
+ * @param numThreads The number of formatting threads (0 uses every core).
+ */
+void TASink::writeChunks(size_t numChunks, const function<void(size_t, string&)>& format, int numThreads){
+    if (numThreads <= 0) numThreads = (int) thread::hardware_concurrency();
+    size_t workers = min((size_t) max(numThreads, 1), numChunks);
+
+    //Small jobs are formatted straight into the buffer.
+    if (workers <= 1){
+        for (size_t i = 0; i < numChunks; i++){
+            format(i, data);
+            commit();
+        }
+        return;
+    }
+
+    //Ring of chunk buffers shared by the workers and the writer.
+    struct Slot {
+        string text;
+        size_t chunk;
+        bool ready;
+    };
+    size_t window = workers * 2;
+    vector<Slot> slots(window, Slot{string(), 0, false});
+    mutex lock;
+    condition_variable changed;
+    size_t next = 0;
+    size_t written = 0;
+
+    auto worker = [&](){
+        while (true){
+            //Claim the next chunk once its slot is free.
+            size_t i;
+            {
+                unique_lock<mutex> guard(lock);
+                changed.wait(guard, [&](){ return next >= numChunks || next < written + window; });
+                if (next >= numChunks) return;
+                i = next++;
+            }
+
+            Slot& slot = slots[i % window];
+            slot.text.clear();
+            format(i, slot.text);
+            {
+                lock_guard<mutex> guard(lock);
+                slot.chunk = i;
+                slot.ready = true;
+            }
+            changed.notify_all();
+        }
+    };
+
+    vector<thread> threads;
+    for (size_t i = 0; i < workers; i++) threads.push_back(thread(worker));
+
+    //Append the chunks in order as they finish.
+    for (size_t i = 0; i < numChunks; i++){
+        Slot& slot = slots[i % window];
+        {
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [&](){ return slot.ready && slot.chunk == i; });
+        }
+
+        data.append(slot.text);
+        commit();
+        {
+            lock_guard<mutex> guard(lock);
+            slot.ready = false;
+            written++;
+        }
+        changed.notify_all();
+    }
+
+    for (thread& curr : threads) curr.join();
+}
+
+/**
+ * Checks whether every write so far succeeded.
+ * @return Boolean indicating whether the sink is good.
+ */
+bool TASink::good() const {
+    return !failed;
+}
+
+/**
+ * Takes the collected text out of the sink.
+ * @return The text.
+ */
+string TASink::release(){
+    string text;
+    text.swap(data);
+    return text;
+}
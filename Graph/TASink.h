@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TASink.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Buffered sink for TA output. The graph appends each line straight
+// into a large buffer that is written out whenever it fills, so a
+// TA section is never built up in memory as a whole.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_TASINK_H
+#define BFX64_TASINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * Lines are appended to buffer() and committed one at a time. A
+ * sink without a stream never flushes and just collects the text.
+ * A sink can also hand each full buffer of whole lines to a consumer.
+ * Large outputs can instead be split into chunks that are formatted
+ * on several threads and appended in order.
+ */
+class TASink {
+public:
+    /** Bytes Buffered Before a Write */
+    static const size_t DEFAULT_CAPACITY;
+
+    /** Constructors / Destructor */
+    TASink();
+    TASink(std::ostream& out, size_t capacity = DEFAULT_CAPACITY);
+    TASink(std::function<bool(const std::string&)> consumer, size_t capacity = DEFAULT_CAPACITY);
+    ~TASink();
+
+    TASink(const TASink&) = delete;
+    TASink& operator=(const TASink&) = delete;
+
+    /** Output Operations */
+    std::string& buffer();
+    void append(std::string_view text);
+    void appendNumber(uint64_t value);
+    static void appendNumber(std::string& out, uint64_t value);
+    void commit();
+    bool flush();
+    void writeChunks(size_t numChunks, const std::function<void(size_t, std::string&)>& format, int numThreads);
+
+    /** Getters */
+    bool good() const;
+    std::string release();
+
+private:
+    /** Private Variables */
+    std::ostream* out;
+    std::function<bool(const std::string&)> consumer;
+    size_t capacity;
+    std::string data;
+    bool failed;
+};
+
+#endif //BFX64_TASINK_H
@@ -24,10 +24,14 @@
 
 #include <iostream>
 #include <ncurses.h>
+#include <mutex>
 #include "PrintOperation.h"
 
 using namespace std;
 
+/** Serializes output from the extraction threads. */
+static mutex printLock;
+
 /**
  * Sets up a printer to print status.
  * @param verbose Whether we're in verbose mode.
@@ -97,6 +101,7 @@ void PrintOperation::printStartFileSearch() {
     if (!verbose) cout << "Searching for object files..." << flush;
 }
 void PrintOperation::printFileProcess(string fileName) {
+    lock_guard<mutex> guard(printLock);
     if (!verbose) {
         printFileProcessNVerbose();
         return;
@@ -122,6 +127,7 @@ void PrintOperation::printFileProcess(string fileName) {
  * @param endianness The endianness.
  */
 void PrintOperation::printFileProcessSub(PrintOperation::Bit bitType, PrintOperation::Endian endianness) {
+    lock_guard<mutex> guard(printLock);
     if (!verbose) {
         printFileProcessNVerbose();
         return;
@@ -156,6 +162,7 @@ void PrintOperation::printFileProcessSub(PrintOperation::Bit bitType, PrintOpera
  * @param opType The current operation.
  */
 void PrintOperation::printFileProcessSub(PrintOperation::Operation opType) {
+    lock_guard<mutex> guard(printLock);
     if (!verbose && (opType != INVALID || opType != PURGE)) {
         printFileProcessNVerbose();
         return;
@@ -181,17 +188,33 @@ void PrintOperation::printFileProcessSub(PrintOperation::Operation opType) {
 }
 
 /**
- * Prints that files are being resolved.
+ * Prints that a file's references are being linked.
+ * @param fileName The file being linked.
  */
-void PrintOperation::printResolving() {
-    cout << "Resolving all undefined references...";
+void PrintOperation::printFileLink(string fileName) {
+    lock_guard<mutex> guard(printLock);
+    if (!verbose) {
+        printFileProcessNVerbose();
+        return;
+    }
+
+    cout << "Linking references in " + fileName + "...\n";
 }
 
 /**
- * Prints that files are done being resolved.
+ * Prints that spilled TA runs are being merged.
  */
-void PrintOperation::printDoneResolving() {
-    cout << "done!" << endl << endl;
+void PrintOperation::printMerging() {
+    cout << "Merging spilled TA runs into a single file..." << endl;
+}
+
+/**
+ * Prints how many template instantiations were folded.
+ * @param numFolded The number of instantiations folded into another node.
+ */
+void PrintOperation::printTemplatesCollapsed(size_t numFolded) {
+    cout << "Collapsed " << numFolded << " template instantiation" << ((numFolded == 1) ? "" : "s")
+         << " into their templates." << endl;
 }
 
 /**
@@ -225,6 +248,17 @@ void PrintOperation::printDoneFileSearch(){
     cout << "done!" << endl << endl;
 }
 
+/**
+ * Prints the object files this process's shard covers.
+ * @param index The shard index.
+ * @param count The number of shards.
+ * @param numFiles The number of object files in the shard.
+ * @param numTotal The number of object files found.
+ */
+void PrintOperation::printShard(int index, int count, size_t numFiles, size_t numTotal){
+    cout << "Shard " << index << "/" << count << " covers " << numFiles << " of " << numTotal << " object files." << endl;
+}
+
 /**
  * Prints that the process is starting.
  */
@@ -272,6 +306,70 @@ void PrintOperation::printTAFailure(std::string fileName){
     cout << "Check appropriate file permissions." << endl;
 }
 
+/**
+ * Prints snapshot success message.
+ * @param fileName Snapshot being outputted.
+ */
+void PrintOperation::printSnapshotSuccess(std::string fileName){
+    cout << "Graph snapshot successfully written to " << fileName << "!" << endl;
+}
+
+/**
+ * Prints snapshot failure message.
+ * @param fileName Snapshot being outputted.
+ */
+void PrintOperation::printSnapshotFailure(std::string fileName){
+    cout << "Graph snapshot could not be written to " << fileName << "!" << endl;
+}
+
+/**
+ * Prints disk backed storage failure message.
+ * @param directory Directory the graph file was created in.
+ */
+void PrintOperation::printStorageFailure(std::string directory){
+    cout << "Graph storage file could not be created in " << ((directory.empty()) ? "the temp directory" : directory) << "!" << endl;
+    cout << "Check appropriate file permissions." << endl;
+}
+
+/**
+ * Prints that the memory budget is too small to keep.
+ * @param budget The memory budget in bytes.
+ * @param retained The bytes kept across purges.
+ */
+void PrintOperation::printBudgetFailure(size_t budget, size_t retained){
+    cout << "The memory budget of " << budget / 1024 << "KB is too small: the symbol index alone takes "
+         << retained / 1024 << "KB and is never purged!" << endl;
+    cout << "Raise --max-memory or purge by file count with --dump instead." << endl;
+}
+
+/**
+ * Prints that a TA file can't be merged.
+ * @param fileName The TA file.
+ * @param reason Why it can't be merged.
+ */
+void PrintOperation::printFragmentFailure(std::string fileName, std::string reason){
+    cerr << "The TA file " << fileName << " " << reason << "!" << endl;
+}
+
+/**
+ * Prints the outcome of a merge.
+ * @param numFragments The number of TA files merged.
+ * @param numFacts The number of facts read.
+ * @param numResolved The number of references resolved by symbol.
+ * @param numUnresolved The number of references left unresolved.
+ * @param numMalformed The number of lines that couldn't be parsed.
+ */
+void PrintOperation::printMergeSummary(size_t numFragments, size_t numFacts, size_t numResolved, size_t numUnresolved,
+                                       size_t numMalformed){
+    cout << "Merged " << numFacts << " facts from " << numFragments << " TA file" << ((numFragments == 1) ? "" : "s")
+         << "." << endl;
+    cout << "Resolved " << numResolved << " reference" << ((numResolved == 1) ? "" : "s") << " by symbol and left "
+         << numUnresolved << " unresolved." << endl;
+    if (numMalformed > 0){
+        cerr << "Skipped " << numMalformed << " malformed line" << ((numMalformed == 1) ? "" : "s") << "." << endl;
+    }
+}
+
 /**
  * Prints the current file process.
  */
@@ -48,19 +48,28 @@ public:
     void printFileProcess(std::string fileName);
     void printFileProcessSub(PrintOperation::Bit bitType, PrintOperation::Endian endianness);
     void printFileProcessSub(PrintOperation::Operation opType);
+    void printFileLink(std::string fileName);
 
-    void printResolving();
-    void printDoneResolving();
+    void printMerging();
+    void printTemplatesCollapsed(size_t numFolded);
 
     void printFileNotFound(std::string fileName);
     void printNoFiles();
 
     void printDoneFileSearch();
+    void printShard(int index, int count, size_t numFiles, size_t numTotal);
     void printStartProcess();
     void printEndProcess();
 
     void printTASuccess(std::string fileName);
     void printTAFailure(std::string fileName);
+    void printSnapshotSuccess(std::string fileName);
+    void printSnapshotFailure(std::string fileName);
+    void printStorageFailure(std::string directory);
+    void printBudgetFailure(size_t budget, size_t retained);
+    void printFragmentFailure(std::string fileName, std::string reason);
+    void printMergeSummary(size_t numFragments, size_t numFacts, size_t numResolved, size_t numUnresolved,
+                           size_t numMalformed);
 
 private:
     bool verbose;
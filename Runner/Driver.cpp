@@ -29,21 +29,258 @@
 #include <boost/program_options.hpp>
 #include <vector>
 #include "../ELF/ElfReader.h"
+#include "TAFunctions.h"
+#include "TAMerge.h"
+#include "TASQLite.h"
+#include "TASplit.h"
+#include "MemoryBudget.h"
 
 using namespace std;
 namespace po = boost::program_options;
 
 /** Default Output Directory */
 const std::string DEFAULT_OUT = "./out.ta";
+const std::string DEFAULT_DB = "./out.db";
 
 /** Program String */
-const std::string DEFAULT_MSG = "Usage: bfx64 [args]"
+const std::string DEFAULT_MSG = "Usage: bfx64 [args]\n       bfx64 merge [args] a.ta b.ta ..."
         "\nUniversity of Waterloo, 2016\nBryan J Muscedere\n\n"
         "Information:\n"
         "Extracts a series of abstract facts from C/C++ programs to allow for a concise,\n"
         "detailed, and whole-system representation of a software project.\nGenerates a Tuple-Attribute file"
         " based on the facts collected.\n\nArguments";
 
+/** Merge String */
+const std::string MERGE_MSG = "Usage: bfx64 merge [args] a.ta b.ta ...\n\n"
+        "Information:\n"
+        "Merges TA files generated separately (e.g. one per library) into a single TA file.\n"
+        "Duplicate facts are written once and references between the files are resolved\n"
+        "by symbol.\n\nArguments";
+
+/**
+ * Applies the compression option, if given.
+ * @param vm The parsed options.
+ * @param desc The options, printed on an error.
+ * @param output The output file, given the codec's extension.
+ * @return Whether the option was valid.
+ */
+static bool setCompression(const po::variables_map& vm, const po::options_description& desc, string& output){
+    if (!vm.count("compress")) return true;
+
+    string spec = vm["compress"].as<string>();
+    TACodec::Codec codec;
+    int level;
+    if (!TACodec::parse(spec, codec, level)){
+        cout << "Error: " << spec << " is not a valid compression setting!" << endl;
+        cout << desc << endl;
+        return false;
+    } else if (!TACodec::isSupported(codec)){
+        cerr << "Error: bfx64 was built without " << TACodec::getName(codec) << " support!" << endl;
+        return false;
+    }
+
+    output = TACodec::addExtension(output, codec);
+    TAFunctions::setCompression(codec, level);
+    return true;
+}
+
+/**
+ * Applies the output format option. Databases are written
+ * uncompressed and with full entity IDs.
+ * @param vm The parsed options.
+ * @param desc The options, printed on an error.
+ * @param output The output file, moved to out.db if not given.
+ * @param database Whether a database is written.
+ * @return Whether the option was valid.
+ */
+static bool setFormat(const po::variables_map& vm, const po::options_description& desc, string& output, bool& database){
+    string format = vm["format"].as<string>();
+    database = format.compare("sqlite") == 0;
+    if (format.compare("ta") == 0) return true;
+
+    if (!database){
+        cout << "Error: " << format << " is not a valid output format!" << endl;
+        cout << desc << endl;
+        return false;
+    } else if (!TASQLite::isSupported()){
+        cerr << "Error: bfx64 was built without SQLite support!" << endl;
+        return false;
+    } else if (vm.count("compress")){
+        cout << "Error: SQLite databases cannot be compressed!" << endl;
+        cout << desc << endl;
+        return false;
+    } else if (vm["compact-ids"].as<bool>()){
+        cout << "Error: SQLite databases cannot be written with short entity IDs!" << endl;
+        cout << desc << endl;
+        return false;
+    }
+
+    if (vm["out"].defaulted()) output = DEFAULT_DB;
+    TAFunctions::setOutputFormat(TAFunctions::SQLITE);
+    return true;
+}
+
+/**
+ * Applies the split option, if given. Split TA files go in a
+ * directory named after the output file.
+ * @param vm The parsed options.
+ * @param desc The options, printed on an error.
+ * @param output The output, replaced by the directory.
+ * @return Whether the option was valid.
+ */
+static bool setSplit(const po::variables_map& vm, const po::options_description& desc, string& output){
+    if (!vm.count("split-by")) return true;
+
+    string spec = vm["split-by"].as<string>();
+    int depth;
+    if (!TASplit::parseSplit(spec, depth)){
+        cout << "Error: " << spec << " is not a valid way to split the TA file!" << endl;
+        cout << desc << endl;
+        return false;
+    } else if (vm["compact-ids"].as<bool>()){
+        cout << "Error: Split TA files cannot be written with short entity IDs!" << endl;
+        cout << desc << endl;
+        return false;
+    } else if (vm["format"].as<string>().compare("ta") != 0){
+        cout << "Error: Only TA files can be split!" << endl;
+        cout << desc << endl;
+        return false;
+    }
+
+    output = boost::filesystem::path(vm["out"].as<string>()).replace_extension("").string();
+    TAFunctions::setSplitDepth(depth);
+    return true;
+}
+
+/**
+ * Driver for the merge command. Loads each TA file into one
+ * graph and writes the graph out.
+ * @param argc The number of arguments, starting at "merge".
+ * @param argv Vector of arguments, starting at "merge".
+ * @return Return code.
+ */
+static int runMerge(int argc, const char *argv[]) {
+    bool compactFlag;
+    bool sortedFlag;
+    bool fragmentFlag;
+    bool databaseFlag;
+
+    //Sets up the program options.
+    po::options_description desc(MERGE_MSG);
+    desc.add_options()
+            ("help,h", "Show the help message.")
+            ("out,o", po::value<string>()->default_value(DEFAULT_OUT), "Sets the output file (instead of out.ta).")
+            ("compress,z", po::value<string>(), "Compresses the TA file as it is written (gzip or zstd, optionally with a "
+                    "level such as gzip:9).")
+            ("compact-ids,C", po::bool_switch(&compactFlag), "Writes short entity IDs (e.g. f12) and moves full paths "
+                    "and sections into attributes. IDs number the entities in order, so adding or removing a file "
+                    "renumbers the ones after it.")
+            ("sorted", po::bool_switch(&sortedFlag), "Sorts every TA section line by line so identical facts always "
+                    "give byte-identical files.")
+            ("fragment,f", po::bool_switch(&fragmentFlag), "Keeps the symbols and the references still unresolved, so "
+                    "the merged TA file can itself be merged.")
+            ("split-by", po::value<string>(), "Writes one TA file per subsystem (subsystem, or subsystem:2 for a deeper "
+                    "level) into a directory named after the output, with crossing edges in _cross.ta.")
+            ("format", po::value<string>()->default_value("ta"), "Sets the output format: a TA file (ta) or an indexed "
+                    "SQLite database (sqlite, written to out.db by default).")
+            ("threads,t", po::value<int>()->default_value(0), "Sets the number of parsing and output threads (0 uses every core).")
+            ("input", po::value<vector<string>>(), "A TA file to merge.");
+            ;
+    po::positional_options_description positional;
+    positional.add("input", -1);
+
+    //Creates a variable map.
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+    } catch (const std::exception& ex) {
+        cerr << "Error: " <<  ex.what() << endl << endl;
+        cout << desc << endl;
+        return 1;
+    }
+    po::notify(vm);
+
+    //Check for help.
+    if (vm.count("help") || !vm.count("input")){
+        cout << desc << endl;
+        return 1;
+    }
+
+    string output = vm["out"].as<string>();
+    int numThreads = vm["threads"].as<int>();
+    if (numThreads < 0){
+        cout << "Error: The number of threads cannot be negative!" << endl;
+        cout << desc << endl;
+        return 1;
+    }
+    if (fragmentFlag && compactFlag){
+        cout << "Error: Fragments cannot be written with short entity IDs!" << endl;
+        cout << desc << endl;
+        return 1;
+    }
+    if (!setFormat(vm, desc, output, databaseFlag)) return 1;
+    if (fragmentFlag && databaseFlag){
+        cout << "Error: Fragments can only be written as TA files!" << endl;
+        cout << desc << endl;
+        return 1;
+    }
+    if (!setCompression(vm, desc, output)) return 1;
+    if (!setSplit(vm, desc, output)) return 1;
+    if (fragmentFlag && vm.count("split-by")){
+        cout << "Error: Fragments cannot be split!" << endl;
+        cout << desc << endl;
+        return 1;
+    }
+    TAFunctions::setCompactIDs(compactFlag);
+    TAFunctions::setSortedOutput(sortedFlag);
+
+    //Maps every TA file before any are parsed.
+    PrintOperation printer = PrintOperation(false);
+    vector<string> inputs = vm["input"].as<vector<string>>();
+    TAGraph graph;
+    graph.setLinkAttributes(fragmentFlag);
+    graph.setKeepSymbols(databaseFlag);
+    TAMerge merger(&graph, numThreads);
+    for (string input : inputs){
+        TAMerge::Status status = merger.addFragment(input);
+        if (status == TAMerge::UNREADABLE){
+            printer.printFragmentFailure(input, "could not be read");
+        } else if (status == TAMerge::NOT_TA){
+            printer.printFragmentFailure(input, "is not a TA file");
+        } else if (status == TAMerge::COMPACT){
+            printer.printFragmentFailure(input, "has short entity IDs and cannot be merged");
+        }
+        if (status != TAMerge::OK) return 1;
+    }
+
+    //Merges the graph and checks every TA file was read.
+    merger.merge();
+    printer.printMergeSummary(inputs.size(), merger.getNumFacts(), merger.getNumResolved(), merger.getNumUnresolved(),
+                              merger.getNumMalformed());
+    bool merged = true;
+    for (size_t i = 0; i < inputs.size(); i++){
+        TAMerge::Status status = merger.checkFragment(i);
+        if (status == TAMerge::NO_FACTS){
+            printer.printFragmentFailure(inputs[i], "has no facts that could be read");
+        } else if (status == TAMerge::MALFORMED){
+            printer.printFragmentFailure(inputs[i], "has too many malformed lines");
+        }
+        if (status != TAMerge::OK) merged = false;
+    }
+    if (!merged) return 1;
+
+    //Writes the merged graph.
+    graph.finalize();
+    if (TAFunctions::generateTAFile(output, &graph, numThreads)){
+        printer.printTASuccess(output);
+    } else {
+        printer.printTAFailure(output);
+        return 1;
+    }
+
+    return 0;
+}
+
 /**
  * Main driver method for the program. Takes in command line
  * arguments using boost and then calls the ElfReader to
@@ -53,9 +290,17 @@ const std::string DEFAULT_MSG = "Usage: bfx64 [args]"
  * @return Return code.
  */
 int main(int argc, const char *argv[]) {
+    //Merging TA files is a separate command.
+    if (argc > 1 && string(argv[1]) == "merge") return runMerge(argc - 1, argv + 1);
+
     bool suppressFlag;
     bool verboseFlag;
     bool lowMemFlag;
+    bool collapseFlag;
+    bool compactFlag;
+    bool sortedFlag;
+    bool fragmentFlag;
+    bool databaseFlag;
 
     //Sets up the program options.
     po::options_description desc(DEFAULT_MSG);
@@ -68,7 +313,35 @@ int main(int argc, const char *argv[]) {
             ("exclude,e", po::value<vector<string>>(), "Removes an object file from bfx64's processing queue.")
             ("verbose,v", po::bool_switch(&verboseFlag), "Sets verbose output for bfx64.")
             ("low,l", po::bool_switch(&lowMemFlag), "Dumps the TA file during analysis (used for low-memory systems).")
-            ("dump,u", po::value<int>()->default_value(ElfReader::DUMP_DEFAULT), "Sets the frequency in which the TA file is updated.");
+            ("dump,u", po::value<int>()->default_value(ElfReader::DUMP_DEFAULT), "Sets the frequency in which the TA file is updated.")
+            ("max-memory,m", po::value<string>(), "Dumps the TA file whenever the graph outgrows a size (e.g. 512M, 4G, or auto "
+                    "for half the memory limit). Implies low memory mode.")
+            ("disk-backed,D", po::value<string>()->implicit_value(""), "Keeps the graph in a memory-mapped file (in the given "
+                    "directory or the temp directory) for graphs larger than memory.")
+            ("collapse-templates,c", po::bool_switch(&collapseFlag), "Folds the instantiations of each function template "
+                    "into a single node per object file.")
+            ("granularity,g", po::value<string>()->default_value("function"), "Sets the level nodes are extracted at "
+                    "(function, file or subsystem).")
+            ("compress,z", po::value<string>(), "Compresses the TA file as it is written (gzip or zstd, optionally with a "
+                    "level such as gzip:9).")
+            ("compact-ids,C", po::bool_switch(&compactFlag), "Writes short entity IDs (e.g. f12) and moves full paths "
+                    "and sections into attributes. IDs number the entities in order, so adding or removing a file "
+                    "renumbers the ones after it.")
+            ("sorted", po::bool_switch(&sortedFlag), "Sorts every TA section line by line so identical facts always "
+                    "give byte-identical files (low memory mode is always sorted).")
+            ("fragment,f", po::bool_switch(&fragmentFlag), "Lists the symbols each entity defines and keeps references "
+                    "by name, so the TA file can be joined to others with bfx64 merge.")
+            ("split-by", po::value<string>(), "Writes one TA file per subsystem (subsystem, or subsystem:2 for a deeper "
+                    "level) into a directory named after the output, with crossing edges in _cross.ta.")
+            ("format", po::value<string>()->default_value("ta"), "Sets the output format: a TA file (ta) or an indexed "
+                    "SQLite database (sqlite, written to out.db by default).")
+            ("shard", po::value<string>(), "Processes one shard of the object files (e.g. 0/4 to 3/4) and writes it as a "
+                    "fragment. Join the shards with bfx64 merge.")
+            ("shard-by", po::value<string>()->default_value("size"), "Splits the shards by balancing file sizes (size) "
+                    "or by path hash (hash).")
+            ("threads,t", po::value<int>()->default_value(0), "Sets the number of extraction and output threads (0 uses every core).")
+            ("snapshot,S", po::value<string>(), "Writes a binary snapshot of the finished graph.")
+            ("from-snapshot,F", po::value<string>(), "Generates the TA file from a snapshot instead of object files.");
             ;
 
     //Creates a variable map.
@@ -92,6 +365,121 @@ int main(int argc, const char *argv[]) {
     string startingDir = vm["dir"].as<string>();
     string output = vm["out"].as<string>();
 
+    //Gets the number of threads.
+    int numThreads = vm["threads"].as<int>();
+    if (numThreads < 0){
+        cout << "Error: The number of threads cannot be negative!" << endl;
+        cout << desc << endl;
+        return 1;
+    }
+
+    //Gets the output format and compression settings.
+    if (!setFormat(vm, desc, output, databaseFlag)) return 1;
+    if (!setCompression(vm, desc, output)) return 1;
+    if (!setSplit(vm, desc, output)) return 1;
+    TAFunctions::setCompactIDs(compactFlag);
+    TAFunctions::setSortedOutput(sortedFlag);
+
+    //Gets the shard to process. Shards are always written as fragments.
+    int shardIndex = 0, shardCount = 1;
+    ElfReader::ShardMode shardMode = ElfReader::BY_SIZE;
+    if (vm.count("shard")){
+        string shardBy = vm["shard-by"].as<string>();
+        if (!ElfReader::parseShard(vm["shard"].as<string>(), shardIndex, shardCount)){
+            cout << "Error: " << vm["shard"].as<string>() << " is not a valid shard!" << endl;
+            cout << desc << endl;
+            return 1;
+        } else if (shardBy.compare("size") != 0 && shardBy.compare("hash") != 0){
+            cout << "Error: " << shardBy << " is not a valid way to split shards!" << endl;
+            cout << desc << endl;
+            return 1;
+        }
+
+        if (shardBy.compare("hash") == 0) shardMode = ElfReader::BY_HASH;
+        fragmentFlag = true;
+    }
+
+    //Link attributes come from the symbol tables.
+    if (fragmentFlag && compactFlag){
+        cout << "Error: Fragments cannot be written with short entity IDs!" << endl;
+        cout << desc << endl;
+        return 1;
+    } else if (fragmentFlag && databaseFlag){
+        cout << "Error: Fragments can only be written as TA files!" << endl;
+        cout << desc << endl;
+        return 1;
+    } else if (fragmentFlag && vm.count("split-by")){
+        cout << "Error: Fragments cannot be split!" << endl;
+        cout << desc << endl;
+        return 1;
+    } else if (fragmentFlag && vm.count("from-snapshot")){
+        cout << "Error: Fragments cannot be written from a snapshot!" << endl;
+        cout << desc << endl;
+        return 1;
+    }
+
+    //Regenerates the TA file from a snapshot without reading object files.
+    if (vm.count("from-snapshot")){
+        string snapshot = vm["from-snapshot"].as<string>();
+        TAGraph* graph = TAFunctions::loadSnapshot(snapshot);
+        if (graph == nullptr){
+            cerr << "Error: " << snapshot << " is not a valid bfx64 snapshot!" << endl;
+            return 1;
+        }
+
+        PrintOperation printer = PrintOperation(verboseFlag);
+        bool succ = TAFunctions::generateTAFile(output, graph, numThreads);
+        if (succ){
+            printer.printTASuccess(output);
+        } else {
+            printer.printTAFailure(output);
+        }
+
+        delete graph;
+        return (succ) ? 0 : 1;
+    }
+
+    //Gets the memory budget. Budgets only apply in low memory mode.
+    size_t memoryBudget = 0;
+    if (vm.count("max-memory")){
+        if (!MemoryBudget::parse(vm["max-memory"].as<string>(), memoryBudget)){
+            cout << "Error: " << vm["max-memory"].as<string>() << " is not a valid memory size!" << endl;
+            cout << desc << endl;
+            return 1;
+        }
+        lowMemFlag = true;
+    }
+
+    //Short IDs and link attributes are gathered over the whole graph.
+    if (compactFlag && lowMemFlag){
+        cout << "Error: Short entity IDs cannot be written in low memory mode!" << endl;
+        cout << desc << endl;
+        return 1;
+    } else if (fragmentFlag && lowMemFlag){
+        cout << "Error: Fragments cannot be written in low memory mode!" << endl;
+        cout << desc << endl;
+        return 1;
+    } else if (databaseFlag && lowMemFlag){
+        cout << "Error: SQLite databases cannot be written in low memory mode!" << endl;
+        cout << desc << endl;
+        return 1;
+    } else if (vm.count("split-by") && lowMemFlag){
+        cout << "Error: Split TA files cannot be written in low memory mode!" << endl;
+        cout << desc << endl;
+        return 1;
+    }
+
+    //Gets the snapshot to write.
+    string snapshot;
+    if (vm.count("snapshot")){
+        snapshot = vm["snapshot"].as<string>();
+        if (lowMemFlag){
+            cout << "Error: Snapshots cannot be written in low memory mode!" << endl;
+            cout << desc << endl;
+            return 1;
+        }
+    }
+
     //Gets the input and output args.
     vector<string> inputFiles;
     vector<string> outputFiles;
@@ -117,9 +505,35 @@ int main(int argc, const char *argv[]) {
         dumpFreq = ElfReader::DUMP_DEFAULT;
     }
 
+    //With a budget, only purge on file counts if asked to.
+    if (memoryBudget > 0 && vm["dump"].defaulted()) dumpFreq = 0;
+
+    //Gets the granularity.
+    ElfReader::Granularity granularity;
+    string level = vm["granularity"].as<string>();
+    if (level.compare("function") == 0){
+        granularity = ElfReader::FUNCTION;
+    } else if (level.compare("file") == 0){
+        granularity = ElfReader::FILE;
+    } else if (level.compare("subsystem") == 0){
+        granularity = ElfReader::SUBSYSTEM;
+    } else {
+        cout << "Error: " << level << " is not a valid granularity!" << endl;
+        cout << desc << endl;
+        return 1;
+    }
+
     //Starts theo ELFReader.
-    ElfReader reader = ElfReader(startingDir, output, suppressFlag, verboseFlag, lowMemFlag, dumpFreq);
-    reader.read(inputFiles, outputFiles);
+    ElfReader reader = ElfReader(startingDir, output, suppressFlag, verboseFlag, lowMemFlag, dumpFreq, numThreads);
+    reader.setSnapshot(snapshot);
+    reader.setMemoryBudget(memoryBudget);
+    reader.setCollapseTemplates(collapseFlag);
+    reader.setLinkAttributes(fragmentFlag);
+    reader.setKeepSymbols(databaseFlag);
+    reader.setShard(shardIndex, shardCount, shardMode);
+    reader.setGranularity(granularity);
+    if (vm.count("disk-backed")) reader.setDiskBacked(vm["disk-backed"].as<string>());
+    bool succ = reader.read(inputFiles, outputFiles);
 
-    return 0;
+    return (succ) ? 0 : 1;
 }
\ No newline at end of file
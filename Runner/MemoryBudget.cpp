@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MemoryBudget.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Helpers for the low memory budget. Parses human readable sizes
+// and detects the memory limit of the container bfx64 runs in, so
+// the graph can be purged whenever it would outgrow the budget
+// instead of after a fixed number of files.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <unistd.h>
+#include "MemoryBudget.h"
+
+using namespace std;
+
+const string MemoryBudget::AUTO = "auto";
+const int MemoryBudget::AUTO_PERCENT = 50;
+
+/** Cgroup Limit Files */
+static const string CGROUP_ROOT = "/sys/fs/cgroup";
+static const string CGROUP_V2_LIMIT = "/memory.max";
+static const string CGROUP_V1_LIMIT = "/memory/memory.limit_in_bytes";
+
+/** Cgroup v1 Reports No Limit as a Huge Value */
+static const uint64_t CGROUP_UNLIMITED = (uint64_t) 1 << 60;
+
+/**
+ * Parses a memory budget. Takes a size such as 512M or 4G,
+ * or "auto" to derive the budget from the detected limit.
+ * @param value The budget argument.
+ * @param bytes The budget in bytes.
+ * @return Whether the budget was valid.
+ */
+bool MemoryBudget::parse(const string& value, size_t& bytes){
+    if (value.compare(AUTO) == 0){
+        bytes = detectLimit() / 100 * AUTO_PERCENT;
+        return bytes > 0;
+    }
+
+    uint64_t size;
+    if (!parseSize(value, size) || size == 0 || size > SIZE_MAX) return false;
+    bytes = (size_t) size;
+    return true;
+}
+
+/**
+ * Detects the memory available to the process. Checks the
+ * cgroup v2 limit of our own cgroup, then the cgroup v1 limit,
+ * then falls back to physical memory.
+ * @return The memory limit in bytes (or 0 if unknown).
+ */
+size_t MemoryBudget::detectLimit(){
+    uint64_t limit;
+
+    //Containers usually mount their own cgroup at the root.
+    string own = getCgroupPath();
+    if (!own.empty() && readLimit(CGROUP_ROOT + own + CGROUP_V2_LIMIT, limit)) return (size_t) limit;
+    if (readLimit(CGROUP_ROOT + CGROUP_V2_LIMIT, limit)) return (size_t) limit;
+    if (readLimit(CGROUP_ROOT + CGROUP_V1_LIMIT, limit)) return (size_t) limit;
+
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) return 0;
+    return (size_t) pages * (size_t) pageSize;
+}
+
+/**
+ * Parses a size with an optional K, M, G or T suffix. The
+ * suffixes are powers of 1024.
+ * @param value The size string.
+ * @param bytes The size in bytes.
+ * @return Whether the size was valid.
+ */
+bool MemoryBudget::parseSize(const string& value, uint64_t& bytes){
+    size_t pos = 0;
+    uint64_t number = 0;
+    while (pos < value.size() && value[pos] >= '0' && value[pos] <= '9'){
+        uint64_t digit = (uint64_t) (value[pos++] - '0');
+        if (number > (UINT64_MAX - digit) / 10) return false;
+        number = number * 10 + digit;
+    }
+    if (pos == 0) return false;
+
+    //Read the unit.
+    int shift = 0;
+    if (pos < value.size()){
+        char unit = (char) toupper(value[pos++]);
+        if (unit == 'K') shift = 10;
+        else if (unit == 'M') shift = 20;
+        else if (unit == 'G') shift = 30;
+        else if (unit == 'T') shift = 40;
+        else return false;
+
+        //Allow KB, MB, etc.
+        if (pos < value.size() && toupper(value[pos]) == 'B') pos++;
+    }
+    if (pos != value.size()) return false;
+    if (shift > 0 && number > (UINT64_MAX >> shift)) return false;
+
+    bytes = number << shift;
+    return true;
+}
+
+/**
+ * Reads a cgroup memory limit file.
+ * @param file The limit file.
+ * @param bytes The limit in bytes.
+ * @return Whether the file held a real limit.
+ */
+bool MemoryBudget::readLimit(const string& file, uint64_t& bytes){
+    std::ifstream in(file.c_str());
+    string value;
+    if (!in.is_open() || !(in >> value)) return false;
+
+    //Both "max" and the v1 sentinel mean there is no limit.
+    if (!parseSize(value, bytes) || bytes == 0 || bytes >= CGROUP_UNLIMITED) return false;
+    return true;
+}
+
+/**
+ * Gets the cgroup v2 path of this process.
+ * @return The path below the cgroup root (or an empty string).
+ */
+string MemoryBudget::getCgroupPath(){
+    std::ifstream in("/proc/self/cgroup");
+    string line;
+    while (getline(in, line)){
+        //The unified hierarchy is listed as "0::<path>".
+        if (line.compare(0, 3, "0::") != 0) continue;
+
+        string path = line.substr(3);
+        return (path.compare("/") == 0) ? string() : path;
+    }
+    return string();
+}
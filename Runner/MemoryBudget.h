@@ -0,0 +1,54 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MemoryBudget.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Helpers for the low memory budget. Parses human readable sizes
+// and detects the memory limit of the container bfx64 runs in, so
+// the graph can be purged whenever it would outgrow the budget
+// instead of after a fixed number of files.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_MEMORYBUDGET_H
+#define BFX64_MEMORYBUDGET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MemoryBudget {
+public:
+    /** Keyword for a Detected Budget */
+    static const std::string AUTO;
+
+    /** Budget Functions */
+    static bool parse(const std::string& value, size_t& bytes);
+    static size_t detectLimit();
+
+private:
+    /** Share of the Detected Limit Given to the Graph */
+    static const int AUTO_PERCENT;
+
+    /** Helper Methods */
+    static bool parseSize(const std::string& value, uint64_t& bytes);
+    static bool readLimit(const std::string& file, uint64_t& bytes);
+    static std::string getCgroupPath();
+};
+
+#endif //BFX64_MEMORYBUDGET_H
@@ -26,6 +26,8 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "TAFunctions.h"
+#include "TASQLite.h"
+#include "TASplit.h"
 
 const string TAFunctions::SCHEMA = "//Generated TA File\n//Author: Jingwei Wu & Bryan J Muscedere\n\nSCHEME TUPLE :\nre"
         "ference\tcRoot\t\t\tcRoot\ncontain\t\tcRoot\t\t\tcRoot\n\n$INHERIT\tcArchitecturalNds\tcRoot\n$INHERIT\tcAsgNd"
@@ -35,95 +37,249 @@ const string TAFunctions::SCHEMA = "//Generated TA File\n//Author: Jingwei Wu &
         "s {\n\tbeg\n\tend\n\tfile\n\tline\n\tvalue\n\tcolor = (0.0 0.0 0.0)\n}\n\ncArchitecturalNds {\n\tclass_style ="
         " 4\n\tcolor = (0.0 0.0 1.0)\n\tcolor = (0.0 0.0 0.0)\n}\n\ncSubSystem {\n\tclass_style = 4\n\tcolor = (0.0 0.0"
         " 1.0)\n}\n\ncObjectFile {\n\tclass_style = 4\n\tcolor = (0.6 0.8 0.6)\n\tlabelcolor = (0.0 0.0 0.0)\n}\n\ncFun"
-        "ction {\n\tcolor = (1.0 0.0 0.0)\n\tlabelcolor = (0.0 0.0 0.0)\n}\n\n(reference) {\n\tcolor = (0.0 0.0 0.0)\n}"
-        "\n\n";
+        "ction {\n\tcolor = (1.0 0.0 0.0)\n\tlabelcolor = (0.0 0.0 0.0)\n}\n\n(reference) {\n\tcolor = (0.0 0.0 0.0)"
+        "\n\trefs\n}\n\n";
+const string TAFunctions::COMPACT_SCHEMA = "cRoot {\n\tpath\n\tobject\n\tsection\n}\n\n";
+const string TAFunctions::LINK_SCHEMA = "cRoot {\n\tsymbols\n\tlinks\n}\n\n";
 const string TAFunctions::O_FILE_EXT = ".o";
 const string TAFunctions::C_FILE_EXT = ".c";
 const string TAFunctions::CPLUS_FILE_EXT = ".cc";
 const string TAFunctions::CPLUSPLUS_FILE_EXT = ".cpp";
-std::ofstream TAFunctions::taDump;
+TASpill* TAFunctions::taSpill = nullptr;
+TACodec::Codec TAFunctions::codec = TACodec::NONE;
+int TAFunctions::level = 0;
+bool TAFunctions::compactIDs = false;
+bool TAFunctions::sortedOutput = false;
+const size_t TAFunctions::SORT_RUN_BYTES = 64 * 1024 * 1024;
+TAFunctions::Format TAFunctions::format = TAFunctions::TA;
+int TAFunctions::splitDepth = 0;
 
 /**
  * Generates a TA file based on some output path.
  * Does this based on the graph that has been generated
  * since this function was called.
  * @param outputPath The output file path.
+ * @param graph The graph to write.
+ * @param numThreads The number of threads formatting sections (0 uses every core).
  * @return Return code indicating success.
  */
-bool TAFunctions::generateTAFile(string outputPath, TAGraph* graph){
-    //Create file pointer.
-    std::ofstream taFile;
-    taFile.open (outputPath.c_str());
+bool TAFunctions::generateTAFile(string outputPath, TAGraph* graph, int numThreads){
+    if (format == SQLITE) return TASQLite::writeDatabase(outputPath, graph);
+    if (splitDepth > 0){
+        TASplit splitter(graph, splitDepth, numThreads);
+        return splitter.write(outputPath, getSchema(graph), codec, level, sortedOutput);
+    }
+    if (sortedOutput) return generateSortedTAFile(outputPath, graph, numThreads);
+
+    //Create the output stream, compressed if asked.
+    TAOutStream taFile(outputPath, codec, level);
 
     //Check if the file is opened.
-    if (!taFile.is_open()){
+    if (!taFile.isOpen()){
         return false;
     }
 
+    //Sections are written through the sink as they're generated.
+    TASink sink(taFile);
+
     //First, we start by generating the schema.
-    taFile << SCHEMA;
+    graph->setCompactIDs(compactIDs);
+    sink.append(getSchema(graph));
 
     //Next, we create the instance system.
-    taFile << "FACT TUPLE :" << endl;
-    taFile << graph->printInstances();
+    sink.append("FACT TUPLE :\n");
+    graph->printInstances(sink, numThreads);
 
     //Next, we create the relationships.
-    taFile << graph->printRelationships();
+    graph->printRelationships(sink, numThreads);
 
     //Finally, we print attribute information.
-    taFile << endl << "FACT ATTRIBUTE :" << endl;
-    taFile << graph->printAttributes();
+    sink.append("\nFACT ATTRIBUTE :\n");
+    graph->printAttributes(sink, numThreads);
 
-    taFile.close();
+    bool succ = sink.flush();
+    return taFile.close() && succ;
+}
 
-    return true;
+/**
+ * Generates a TA file with every section sorted line by line.
+ * Sections are cut into sorted runs as they're generated and the
+ * runs are merged into the file, so the output only depends on
+ * the facts and not on how the graph was built or stored.
+ * @param outputPath The output file path.
+ * @param graph The graph to write.
+ * @param numThreads The number of threads formatting and sorting.
+ * @return Return code indicating success.
+ */
+bool TAFunctions::generateSortedTAFile(string outputPath, TAGraph* graph, int numThreads){
+    TASpill spill(outputPath, codec, level);
+    spill.setNumThreads(numThreads);
+    if (!spill.start()) return false;
+
+    graph->setCompactIDs(compactIDs);
+    auto sortSection = [&spill, graph, numThreads](TASpill::Section section){
+        TASink sink([&spill, section](const string& lines){
+            return spill.addRun(section, lines);
+        }, SORT_RUN_BYTES);
+
+        if (section == TASpill::INSTANCES){
+            graph->printInstances(sink, numThreads);
+        } else if (section == TASpill::RELATIONSHIPS){
+            graph->printRelationships(sink, numThreads);
+        } else {
+            graph->printAttributes(sink, numThreads);
+        }
+        return sink.flush();
+    };
+
+    for (int i = 0; i < TASpill::NUM_SECTIONS; i++){
+        if (!sortSection((TASpill::Section) i)) return false;
+    }
+    return spill.finish(getSchema(graph));
 }
 
 /**
- * Starts the TA generation.
+ * Gets the schema of a TA file, with the extra attributes
+ * short IDs and link attributes need.
+ * @param graph The graph being written.
+ * @return The schema.
+ */
+string TAFunctions::getSchema(TAGraph* graph){
+    string schema = SCHEMA;
+    if (compactIDs) schema += COMPACT_SCHEMA;
+    if (graph->hasLinkAttributes()) schema += LINK_SCHEMA;
+    return schema;
+}
+
+/**
+ * Writes a frozen graph to a binary snapshot that can be
+ * loaded later without reading any object files.
+ * @param snapshotPath The snapshot file path.
+ * @param graph The finalized graph.
+ * @return Whether the snapshot was written.
+ */
+bool TAFunctions::writeSnapshot(string snapshotPath, TAGraph* graph){
+    const CSRGraph* frozen = graph->getFrozenGraph();
+    if (frozen == nullptr) return false;
+
+    return frozen->save(snapshotPath);
+}
+
+/**
+ * Loads a graph from a binary snapshot. The snapshot is
+ * mapped into memory and served from there.
+ * @param snapshotPath The snapshot file path.
+ * @return The loaded graph (or nullptr if it could not be read).
+ */
+TAGraph* TAFunctions::loadSnapshot(string snapshotPath){
+    CSRGraph* frozen = CSRGraph::load(snapshotPath);
+    if (frozen == nullptr) return nullptr;
+
+    return new TAGraph(frozen);
+}
+
+/**
+ * Starts the TA generation for low memory mode. Graph
+ * contents are spilled to sorted runs until the end.
  * @param outputPath The output path to add.
+ * @param graph The graph that will be spilled.
+ * @param numThreads The number of threads sorting each run.
  * @return Whether the output was successful.
  */
-bool TAFunctions::startTAGeneration(string outputPath){
-    //Create file pointer.
-    TAFunctions::taDump.open (outputPath.c_str());
-
-    //Check if the file is opened.
-    if (!TAFunctions::taDump.is_open()){
+bool TAFunctions::startTAGeneration(string outputPath, TAGraph* graph, int numThreads){
+    delete taSpill;
+    taSpill = new TASpill(outputPath, codec, level);
+    taSpill->setNumThreads(numThreads);
+
+    //Check that the spill directory is usable.
+    if (!taSpill->start()){
+        delete taSpill;
+        taSpill = nullptr;
         return false;
     }
 
-    //First, we start by generating the schema.
-    TAFunctions::taDump << SCHEMA;
+    //Filter hits on purged nodes are confirmed against the runs.
+    graph->setSpillLookup([](string_view ID){
+        return taSpill != nullptr && taSpill->containsInstance(ID);
+    });
     return true;
 }
 
 /**
- * Dumps TA file to disk for low memory.
+ * Spills the graph to sorted runs for low memory
+ * and then purges it.
  * @param graph The graph to dump.
  * @return Whether it was successful.
  */
 bool TAFunctions::dumpTAFile(TAGraph* graph){
-    //Processes the schema up to this point.
-    TAFunctions::taDump << "FACT TUPLE :" << endl;
-    TAFunctions::taDump << graph->printInstances();
+    if (taSpill == nullptr) return false;
 
-    //Next, we create the relationships.
-    TAFunctions::taDump << graph->printRelationships();
-
-    //Finally, we print attribute information.
-    TAFunctions::taDump << endl << "FACT ATTRIBUTE :" << endl;
-    TAFunctions::taDump << graph->printAttributes();
+    //Writes the graph contents out as sorted runs.
+    if (!taSpill->spill(graph)) return false;
 
     //Removes the nodes.
     return graph->removeAllNodes();
 }
 
 /**
- * Ends the TA file.
+ * Ends the TA file by merging all runs into a
+ * single deduplicated TA file.
+ * @return Whether the TA file was written.
+ */
+bool TAFunctions::endTAFile(){
+    if (taSpill == nullptr) return false;
+
+    bool succ = taSpill->finish(SCHEMA);
+    delete taSpill;
+    taSpill = nullptr;
+    return succ;
+}
+
+/**
+ * Sets the compression used for every TA file written
+ * from here on.
+ * @param codec The codec to compress with.
+ * @param level The compression level.
+ */
+void TAFunctions::setCompression(TACodec::Codec codec, int level){
+    TAFunctions::codec = codec;
+    TAFunctions::level = level;
+}
+
+/**
+ * Sets whether TA files are written with short entity IDs,
+ * with full paths and sections moved into attributes.
+ * @param compact Whether to write short IDs.
  */
-void TAFunctions::endTAFile(){
-    TAFunctions::taDump.close();
+void TAFunctions::setCompactIDs(bool compact){
+    TAFunctions::compactIDs = compact;
+}
+
+/**
+ * Sets whether TA files are written with every section sorted,
+ * giving byte-identical files for identical facts.
+ * @param sorted Whether to sort the output.
+ */
+void TAFunctions::setSortedOutput(bool sorted){
+    TAFunctions::sortedOutput = sorted;
+}
+
+/**
+ * Sets whether the finished graph is written as a TA file or
+ * loaded into a SQLite database.
+ * @param format The output format.
+ */
+void TAFunctions::setOutputFormat(Format format){
+    TAFunctions::format = format;
+}
+
+/**
+ * Sets whether the finished graph is split into one TA file per
+ * subsystem, written into a directory instead of a single file.
+ * @param depth The subsystem depth to split at, or 0 for one file.
+ */
+void TAFunctions::setSplitDepth(int depth){
+    TAFunctions::splitDepth = depth;
 }
 
 /**
@@ -160,9 +316,11 @@ vector<path> TAFunctions::getSourceFiles(TAGraph* graph, PrintOperation parentPr
  * @param printer The printer to print file processes.
  * @param curr The current path being looked at.
  * @param prev The previous path looked at.
+ * @param fileNodes Whether object files get nodes (or only their directories).
  * @return Vector of object files.
  */
-vector<path> TAFunctions::getObjectFiles(TAGraph* graph, PrintOperation parentPrint, path curr, path prev){
+vector<path> TAFunctions::getObjectFiles(TAGraph* graph, PrintOperation parentPrint, path curr, path prev,
+                                         bool fileNodes){
     //Generate a vector of extensions.
     vector<string> extVec = vector<string>();
     extVec.push_back(TAFunctions::O_FILE_EXT);
@@ -171,7 +329,7 @@ vector<path> TAFunctions::getObjectFiles(TAGraph* graph, PrintOperation parentPr
     vector<path> files = getFiles(curr, prev, extVec, parentPrint);
 
     //Process the files.
-    addFiles(graph, files);
+    addFiles(graph, files, fileNodes);
 
     return files;
 }
@@ -232,8 +390,9 @@ vector<path> TAFunctions::getFiles(path curr, path prev, vector<string> ext, Pri
  * that only paths containing object files are added.
  * @param graph The TA graph being used.
  * @param files A list of object files being processed.
+ * @param fileNodes Whether the files get nodes (or only their directories).
  */
-void TAFunctions::addFiles(TAGraph* graph, vector<path> files){
+void TAFunctions::addFiles(TAGraph* graph, vector<path> files, bool fileNodes){
     //Iterate through each of the files.
     for (path current : files){
         string fileName = current.filename().string();
@@ -245,6 +404,7 @@ void TAFunctions::addFiles(TAGraph* graph, vector<path> files){
                               canonical(pItem.string()).string() : canonical(pItem.string(),  path(previous)).string());
 
             //Create the pItem node.
+            if (fileName.compare(pItem.string()) == 0 && !fileNodes) break;
             if (fileName.compare(pItem.string()) != 0){
                 graph->addNode(curItem, BFXNode::SUBSYSTEM, pItem.string(), "");
             } else {
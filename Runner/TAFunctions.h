@@ -35,24 +35,41 @@
 #include <fstream>
 #include "../Graph/TAGraph.h"
 #include "../Print/PrintOperation.h"
+#include "TASpill.h"
+#include "TAStream.h"
 
 using namespace std;
 using namespace boost::filesystem;
 
 class TAFunctions {
 public:
+    /** Output Formats */
+    enum Format { TA, SQLITE };
+
     /** Processing Functions */
-    static bool generateTAFile(string outputPath, TAGraph* graph);
-    static bool startTAGeneration(string outputPath);
+    static bool generateTAFile(string outputPath, TAGraph* graph, int numThreads = 1);
+    static bool startTAGeneration(string outputPath, TAGraph* graph, int numThreads = 1);
     static bool dumpTAFile(TAGraph* graph);
-    static void endTAFile();
+    static bool endTAFile();
+    static void setCompression(TACodec::Codec codec, int level);
+    static void setCompactIDs(bool compact);
+    static void setSortedOutput(bool sorted);
+    static void setOutputFormat(Format format);
+    static void setSplitDepth(int depth);
+
+    /** Snapshot Functions */
+    static bool writeSnapshot(string snapshotPath, TAGraph* graph);
+    static TAGraph* loadSnapshot(string snapshotPath);
 
     static vector<path> getSourceFiles(TAGraph* graph, PrintOperation parentPrint, path curr, path prev);
-    static vector<path> getObjectFiles(TAGraph* graph, PrintOperation parentPrint, path curr, path prev);
+    static vector<path> getObjectFiles(TAGraph* graph, PrintOperation parentPrint, path curr, path prev,
+                                       bool fileNodes = true);
 
 private:
     /** TA Schema */
     static const string SCHEMA;
+    static const string COMPACT_SCHEMA;
+    static const string LINK_SCHEMA;
 
     /** File Extensions */
     static const string O_FILE_EXT;
@@ -62,10 +79,31 @@ private:
 
     /** Private Recursive Helper Methods */
     static vector<path> getFiles(path curr, path prev, vector<string> ext, PrintOperation printer);
-    static void addFiles(TAGraph* graph, vector<path> files);
+    static void addFiles(TAGraph* graph, vector<path> files, bool fileNodes = true);
+
+    /** Low Memory Spill Writer */
+    static TASpill* taSpill;
+
+    /** Output Compression */
+    static TACodec::Codec codec;
+    static int level;
+
+    /** Short Entity IDs */
+    static bool compactIDs;
+
+    /** Sorted Output (Bytes per Sorted Run) */
+    static bool sortedOutput;
+    static const size_t SORT_RUN_BYTES;
+
+    /** Output Format */
+    static Format format;
+
+    /** Subsystem Depth to Split Output At (0 Writes One File) */
+    static int splitDepth;
 
-    /** TA Dump OStream */
-    static std::ofstream taDump;
+    /** Private Output Helpers */
+    static bool generateSortedTAFile(string outputPath, TAGraph* graph, int numThreads);
+    static string getSchema(TAGraph* graph);
 };
 
 #endif //BFX64_TAFUNCTIONS_H
@@ -0,0 +1,543 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TAMerge.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Merges TA files from separate extraction runs into one graph.
+// Plain files are memory-mapped and compressed ones are inflated
+// into memory. Each file is split into line-aligned chunks that
+// are parsed on several threads straight into a TAGraph, which
+// drops duplicate facts. Fragments written with --fragment or
+// --shard keep their references by name; these are linked once
+// the symbols of every fragment are known.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "TAMerge.h"
+#include "TAStream.h"
+
+using namespace std;
+
+const string_view TAMerge::TUPLE_HEADER = "FACT TUPLE :";
+const string_view TAMerge::ATTRIBUTE_HEADER = "FACT ATTRIBUTE :";
+const string_view TAMerge::COMPACT_MARKER = "\tobject\n\tsection\n";
+const string_view TAMerge::LABEL_MARKER = "label = \"";
+const string_view TAMerge::REFS_MARKER = "refs = ";
+const string_view TAMerge::SYMBOLS_MARKER = "symbols = \"";
+const string_view TAMerge::LINKS_MARKER = "links = \"";
+const string_view TAMerge::LINK_SCHEMA_MARKER = "\tsymbols\n\tlinks\n";
+
+/** Sections Whose Names Carry a Symbol */
+static const string_view SYMBOL_SECTIONS[] = {".text.unlikely.", ".text.startup.", ".text.hot.", ".text.",
+                                              ".data.rel.ro.local.", ".data.rel.ro.", ".data.rel.local.",
+                                              ".data.rel.", ".rodata.", ".data.", ".bss.", ".tdata.", ".tbss."};
+
+/**
+ * Releases the mapping of a fragment.
+ */
+TAMerge::Fragment::~Fragment(){
+    if (mapping != nullptr) munmap(mapping, size);
+}
+
+/**
+ * Creates a merger that loads fragments into a graph.
+ * @param graph The graph to merge into.
+ * @param numThreads The number of parsing threads (0 uses every core).
+ */
+TAMerge::TAMerge(TAGraph* graph, int numThreads){
+    this->graph = graph;
+    if (numThreads <= 0) numThreads = (int) thread::hardware_concurrency();
+    this->numThreads = (numThreads <= 0) ? 1 : numThreads;
+}
+
+/**
+ * Destructor. Unmaps every fragment.
+ */
+TAMerge::~TAMerge(){ }
+
+/**
+ * Opens a TA file and finds its sections. Nothing is parsed
+ * until merge() is called.
+ * @param path The TA file, plain or compressed.
+ * @return OK, or the reason the file can't be merged.
+ */
+TAMerge::Status TAMerge::addFragment(string path){
+    unique_ptr<Fragment> fragment(new Fragment());
+
+    //Plain files are mapped, compressed ones are inflated.
+    TAInStream in(path);
+    if (!in.isOpen()) return UNREADABLE;
+    if (in.getCodec() == TACodec::NONE){
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0){
+            if (fd >= 0) close(fd);
+            return UNREADABLE;
+        }
+
+        if (info.st_size > 0){
+            void* mapping = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED){
+                close(fd);
+                return UNREADABLE;
+            }
+            madvise(mapping, (size_t) info.st_size, MADV_SEQUENTIAL);
+            fragment->mapping = mapping;
+            fragment->data = (const char*) mapping;
+            fragment->size = (size_t) info.st_size;
+        }
+        close(fd);
+    } else {
+        const size_t READ_BLOCK = 4 * 1024 * 1024;
+        while (in){
+            size_t used = fragment->text.size();
+            fragment->text.resize(used + READ_BLOCK);
+            in.read(&fragment->text[used], (streamsize) READ_BLOCK);
+            fragment->text.resize(used + (size_t) in.gcount());
+        }
+        if (in.isCorrupt()) return UNREADABLE;
+        fragment->data = fragment->text.data();
+        fragment->size = fragment->text.size();
+    }
+
+    //Finds a header at the start of a line.
+    string_view all(fragment->data, fragment->size);
+    auto findHeader = [&all](string_view header, size_t from){
+        size_t at = all.find(header, from);
+        while (at != string_view::npos && at > 0 && all[at - 1] != '\n') at = all.find(header, at + 1);
+        return at;
+    };
+
+    size_t tuple = findHeader(TUPLE_HEADER, 0);
+    if (tuple == string_view::npos) return NOT_TA;
+    if (all.substr(0, tuple).find(COMPACT_MARKER) != string_view::npos) return COMPACT;
+    fragment->linked = all.substr(0, tuple).find(LINK_SCHEMA_MARKER) != string_view::npos;
+
+    //Each section runs from the line after its header.
+    size_t attribute = findHeader(ATTRIBUTE_HEADER, tuple);
+    size_t tupleEnd = (attribute == string_view::npos) ? all.size() : attribute;
+    size_t tupleStart = min(tupleEnd, all.find('\n', tuple) + 1);
+    fragment->tuples = all.substr(tupleStart, tupleEnd - tupleStart);
+    if (attribute != string_view::npos){
+        size_t attributeStart = all.find('\n', attribute);
+        if (attributeStart != string_view::npos) fragment->attributes = all.substr(attributeStart + 1);
+    }
+
+    //Counts the facts so the graph can be sized up front.
+    const char* curr = fragment->tuples.data();
+    const char* end = curr + fragment->tuples.size();
+    while (curr < end){
+        if (*curr == '$') fragment->numInstances++;
+        fragment->numTuples++;
+
+        const char* newline = (const char*) memchr(curr, '\n', (size_t) (end - curr));
+        curr = (newline == nullptr) ? end : newline + 1;
+    }
+
+    //Attribute lines only count towards the malformed share.
+    curr = fragment->attributes.data();
+    end = curr + fragment->attributes.size();
+    while (curr < end){
+        fragment->numAttributes++;
+
+        const char* newline = (const char*) memchr(curr, '\n', (size_t) (end - curr));
+        curr = (newline == nullptr) ? end : newline + 1;
+    }
+
+    fragments.push_back(std::move(fragment));
+    return OK;
+}
+
+/**
+ * Loads every fragment into the graph. Instances go first so
+ * that edges between fragments find both of their ends.
+ */
+void TAMerge::merge(){
+    size_t numTuples = 0, numInstances = 0;
+    for (const unique_ptr<Fragment>& fragment : fragments){
+        numTuples += fragment->numTuples;
+        numInstances += fragment->numInstances;
+    }
+    graph->reserve(numInstances, numTuples - numInstances, numInstances);
+
+    runPass(true, &TAMerge::parseInstances);
+    runPass(false, &TAMerge::parseLabels);
+    runPass(true, &TAMerge::parseRelationships);
+    runPass(false, &TAMerge::parseCounts);
+}
+
+/**
+ * Checks that a fragment was merged. A fragment fails if it has
+ * a fact section but no facts could be read from it, or if too
+ * many of its lines were malformed.
+ * @param index The fragment, in the order it was added.
+ * @return OK, or the reason the fragment failed.
+ */
+TAMerge::Status TAMerge::checkFragment(size_t index) const {
+    const Fragment& fragment = *fragments[index];
+    if (fragment.numFacts == 0) return NO_FACTS;
+
+    size_t numLines = fragment.numTuples + fragment.numAttributes;
+    if (fragment.numMalformed * 100 > numLines * MAX_MALFORMED_PERCENT) return MALFORMED;
+    return OK;
+}
+
+/**
+ * Gets the number of instance and relationship lines read.
+ * @return The number of facts.
+ */
+size_t TAMerge::getNumFacts() const {
+    return numFacts;
+}
+
+/**
+ * Gets the number of references whose ends were found by symbol.
+ * @return The number of resolved references.
+ */
+size_t TAMerge::getNumResolved() const {
+    return numResolved;
+}
+
+/**
+ * Gets the number of references left unresolved, including
+ * relationships dropped for a missing end.
+ * @return The number of unresolved references.
+ */
+size_t TAMerge::getNumUnresolved() const {
+    return numUnresolved;
+}
+
+/**
+ * Gets the number of lines skipped because they couldn't be parsed.
+ * @return The number of malformed lines.
+ */
+size_t TAMerge::getNumMalformed() const {
+    return numMalformed;
+}
+
+/**
+ * Adds the instances in a chunk of tuple lines.
+ * @param lines The lines to parse.
+ */
+void TAMerge::parseInstances(Fragment& fragment, string_view lines){
+    size_t read = 0, malformed = 0;
+    string_view line, token, ID, typeName;
+    while (nextLine(lines, line)){
+        if (!nextToken(line, token) || token != "$INSTANCE") continue;
+
+        BFXNode::NodeType type;
+        if (!nextToken(line, ID) || !nextToken(line, typeName) || !BFXNode::getTypeFromString(typeName, type)){
+            malformed++;
+            continue;
+        }
+        //Fragments with link attributes list their symbols.
+        graph->addNode(string(ID), type, "", (fragment.linked) ? string() : string(symbolOf(ID)));
+        read++;
+    }
+    numFacts += read;
+    fragment.numFacts += read;
+    addMalformed(fragment, malformed);
+}
+
+/**
+ * Adds the relationships in a chunk of tuple lines. References
+ * to an entity that no fragment defines are moved to the entity
+ * their symbol resolves to.
+ * @param lines The lines to parse.
+ */
+void TAMerge::parseRelationships(Fragment& fragment, string_view lines){
+    size_t read = 0, resolved = 0, unresolved = 0, malformed = 0;
+    string_view line, relation, src, dst;
+    string srcID, dstID;
+    while (nextLine(lines, line)){
+        if (!nextToken(line, relation) || relation == "$INSTANCE") continue;
+
+        BFXEdge::EdgeType type;
+        if (!nextToken(line, src) || !nextToken(line, dst) || !BFXEdge::getTypeFromString(relation, type)){
+            malformed++;
+            continue;
+        }
+        read++;
+        if (graph->addEdge(src, dst, type)) continue;
+
+        //Only references can be resolved by symbol.
+        if (type == BFXEdge::LINK && resolve(src, srcID) && resolve(dst, dstID) &&
+                graph->addEdge(srcID, dstID, type)){
+            resolved++;
+        } else {
+            unresolved++;
+        }
+    }
+    numFacts += read;
+    fragment.numFacts += read;
+    numResolved += resolved;
+    numUnresolved += unresolved;
+    addMalformed(fragment, malformed);
+}
+
+/**
+ * Sets the labels and indexes the symbols in a chunk of attribute
+ * lines.
+ * @param lines The lines to parse.
+ */
+void TAMerge::parseLabels(Fragment& fragment, string_view lines){
+    size_t malformed = 0;
+    string_view line, value, name;
+    string symbol;
+    while (nextLine(lines, line)){
+        if (line.find_first_not_of(" \t") == string_view::npos || line[0] == '(') continue;
+
+        size_t open = line.find(" {");
+        if (open == string_view::npos){
+            malformed++;
+            continue;
+        }
+        string_view ID = line.substr(0, open);
+        line.remove_prefix(open);
+
+        if (quotedValue(line, LABEL_MARKER, value)){
+            graph->setNodeName(ID, value);
+        } else if (quotedValue(line, SYMBOLS_MARKER, value) && graph->doesNodeExist(ID)){
+            while (nextToken(value, name)){
+                symbol.assign(name.data(), name.size());
+                graph->addAlias(ID, symbol);
+            }
+        }
+    }
+    addMalformed(fragment, malformed);
+}
+
+/**
+ * Sets the reference counts in a chunk of attribute lines. A
+ * fact found in two fragments keeps the larger count.
+ * @param lines The lines to parse.
+ */
+void TAMerge::parseCounts(Fragment& fragment, string_view lines){
+    size_t malformed = 0;
+    string_view line, relation, src, dst;
+    string srcID, dstID;
+    while (nextLine(lines, line)){
+        if (line.empty()) continue;
+        if (line[0] != '('){
+            size_t open = line.find(" {");
+            string_view links;
+            if (fragment.linked && open != string_view::npos && quotedValue(line.substr(open), LINKS_MARKER, links)){
+                linkReferences(links);
+            }
+            continue;
+        }
+
+        //Lines look like (relation src dst) { refs = N }.
+        size_t close = line.find(')');
+        size_t refs = line.find(REFS_MARKER, close);
+        string_view edge = (close == string_view::npos) ? string_view() : line.substr(1, close - 1);
+
+        BFXEdge::EdgeType type;
+        uint32_t count = 0;
+        if (refs == string_view::npos || !nextToken(edge, relation) || !nextToken(edge, src) ||
+                !nextToken(edge, dst) || !BFXEdge::getTypeFromString(relation, type) ||
+                from_chars(line.data() + refs + REFS_MARKER.size(), line.data() + line.size(), count).ec != errc()){
+            malformed++;
+            continue;
+        }
+
+        if (graph->raiseEdgeCount(src, dst, type, count)) continue;
+        if (resolve(src, srcID) && resolve(dst, dstID)) graph->raiseEdgeCount(srcID, dstID, type, count);
+    }
+    addMalformed(fragment, malformed);
+}
+
+/**
+ * Links the references a fragment kept by name. Both ends are
+ * looked up in the symbols of every fragment, the same way the
+ * whole tree would have been linked in one run. References still
+ * unresolved are kept if the graph keeps links.
+ * @param links The references, as source>destination names.
+ */
+void TAMerge::linkReferences(string_view links){
+    size_t resolved = 0, unresolved = 0;
+    string_view link;
+    while (nextToken(links, link)){
+        size_t separator = link.find(TAGraph::LINK_SEPARATOR);
+        if (separator == string_view::npos) continue;
+
+        string_view src = link.substr(0, separator);
+        string_view dst = link.substr(separator + 1);
+        if (graph->addEdgeByMangle(src, dst, BFXEdge::LINK)){
+            resolved++;
+        } else {
+            graph->addLink(src, dst);
+            unresolved++;
+        }
+    }
+    numResolved += resolved;
+    numUnresolved += unresolved;
+}
+
+/**
+ * Adds the malformed lines a task skipped to the totals.
+ * @param fragment The fragment the lines came from.
+ * @param malformed The number of lines skipped.
+ */
+void TAMerge::addMalformed(Fragment& fragment, size_t malformed){
+    if (malformed == 0) return;
+    numMalformed += malformed;
+    fragment.numMalformed += malformed;
+}
+
+/**
+ * Runs a parsing pass over every fragment. Sections are cut into
+ * chunks at line breaks and the chunks are shared out to threads.
+ * @param tuples Whether to parse the tuple or attribute sections.
+ * @param parse The parser to run on each chunk.
+ */
+void TAMerge::runPass(bool tuples, void (TAMerge::*parse)(Fragment&, string_view)){
+    vector<Chunk> chunks;
+    for (const unique_ptr<Fragment>& fragment : fragments){
+        string_view lines = (tuples) ? fragment->tuples : fragment->attributes;
+        while (!lines.empty()){
+            size_t end = lines.size();
+            if (end > PARSE_CHUNK){
+                const char* newline = (const char*) memchr(lines.data() + PARSE_CHUNK, '\n', end - PARSE_CHUNK);
+                if (newline != nullptr) end = (size_t) (newline - lines.data()) + 1;
+            }
+            chunks.push_back(Chunk{fragment.get(), lines.substr(0, end)});
+            lines.remove_prefix(end);
+        }
+    }
+
+    atomic<size_t> next{0};
+    auto worker = [this, &chunks, &next, parse](){
+        for (size_t i = next++; i < chunks.size(); i = next++) (this->*parse)(*chunks[i].fragment, chunks[i].lines);
+    };
+
+    size_t workers = min((size_t) numThreads, chunks.size());
+    if (workers <= 1){
+        worker();
+        return;
+    }
+
+    vector<thread> threads;
+    for (size_t i = 0; i < workers; i++) threads.push_back(thread(worker));
+    for (thread& curr : threads) curr.join();
+}
+
+/**
+ * Finds the node an ID stands for. IDs in the graph stand for
+ * themselves; others go to the node defining their symbol.
+ * @param ID The ID from a fragment.
+ * @param resolved The ID of the node in the graph.
+ * @return Whether a node was found.
+ */
+bool TAMerge::resolve(string_view ID, string& resolved){
+    if (graph->doesNodeExist(ID)){
+        resolved.assign(ID.data(), ID.size());
+        return true;
+    }
+
+    string_view symbol = symbolOf(ID);
+    return !symbol.empty() && graph->findIDByMangle(symbol, resolved);
+}
+
+/**
+ * Gets the symbol named by the section in an ID. Symbols built
+ * with one section each (e.g. [.text._Z3barv+0x0]) can be found
+ * this way; others in a shared section can't.
+ * @param ID The ID.
+ * @return The symbol, or empty if the section doesn't name one.
+ */
+string_view TAMerge::symbolOf(string_view ID){
+    if (ID.empty() || ID.back() != ']') return string_view();
+    size_t open = ID.rfind('[');
+    if (open == string_view::npos) return string_view();
+
+    string_view section = ID.substr(open + 1, ID.size() - open - 2);
+    size_t plus = section.rfind('+');
+    if (plus != string_view::npos) section = section.substr(0, plus);
+
+    for (string_view prefix : SYMBOL_SECTIONS){
+        if (section.size() > prefix.size() && section.compare(0, prefix.size(), prefix) == 0){
+            return section.substr(prefix.size());
+        }
+    }
+    return string_view();
+}
+
+/**
+ * Gets a quoted attribute value from an attribute line.
+ * @param line The line.
+ * @param marker The attribute name, equals sign and opening quote.
+ * @param value The text up to the closing quote.
+ * @return Whether the attribute was found.
+ */
+bool TAMerge::quotedValue(string_view line, string_view marker, string_view& value){
+    size_t start = line.find(marker);
+    if (start == string_view::npos) return false;
+
+    start += marker.size();
+    size_t end = line.find('"', start);
+    if (end == string_view::npos) return false;
+
+    value = line.substr(start, end - start);
+    return true;
+}
+
+/**
+ * Takes the next line off a chunk.
+ * @param lines The remaining lines.
+ * @param line The line, without its line break.
+ * @return Whether a line was left.
+ */
+bool TAMerge::nextLine(string_view& lines, string_view& line){
+    if (lines.empty()) return false;
+
+    //memchr is vectorized by the C library.
+    const char* newline = (const char*) memchr(lines.data(), '\n', lines.size());
+    size_t end = (newline == nullptr) ? lines.size() : (size_t) (newline - lines.data());
+    line = lines.substr(0, end);
+    lines.remove_prefix(min(lines.size(), end + 1));
+
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return true;
+}
+
+/**
+ * Takes the next space separated token off a line.
+ * @param line The rest of the line.
+ * @param token The token.
+ * @return Whether a token was left.
+ */
+bool TAMerge::nextToken(string_view& line, string_view& token){
+    size_t start = line.find_first_not_of(" \t");
+    if (start == string_view::npos) return false;
+    line.remove_prefix(start);
+
+    const char* space = (const char*) memchr(line.data(), ' ', line.size());
+    size_t end = (space == nullptr) ? line.size() : (size_t) (space - line.data());
+    token = line.substr(0, end);
+    line.remove_prefix(end);
+    return true;
+}
@@ -0,0 +1,132 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TAMerge.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Merges TA files from separate extraction runs into one graph.
+// Plain files are memory-mapped and compressed ones are inflated
+// into memory. Each file is split into line-aligned chunks that
+// are parsed on several threads straight into a TAGraph, which
+// drops duplicate facts. Fragments written with --fragment or
+// --shard keep their references by name; these are linked once
+// the symbols of every fragment are known.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_TAMERGE_H
+#define BFX64_TAMERGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../Graph/TAGraph.h"
+
+class TAMerge {
+public:
+    /** Reasons a Fragment Can't Be Read or Merged */
+    enum Status { OK, UNREADABLE, NOT_TA, COMPACT, NO_FACTS, MALFORMED };
+
+    /** Constructor / Destructor */
+    TAMerge(TAGraph* graph, int numThreads = 1);
+    ~TAMerge();
+
+    TAMerge(const TAMerge&) = delete;
+    TAMerge& operator=(const TAMerge&) = delete;
+
+    /** Merge Operations */
+    Status addFragment(std::string path);
+    void merge();
+    Status checkFragment(size_t index) const;
+
+    /** Getters */
+    size_t getNumFacts() const;
+    size_t getNumResolved() const;
+    size_t getNumUnresolved() const;
+    size_t getNumMalformed() const;
+
+private:
+    /** Bytes Parsed per Task */
+    static const size_t PARSE_CHUNK = 8 * 1024 * 1024;
+
+    /** Share of Malformed Lines a Fragment Can Have */
+    static const size_t MAX_MALFORMED_PERCENT = 5;
+
+    /** Section Headers */
+    static const std::string_view TUPLE_HEADER;
+    static const std::string_view ATTRIBUTE_HEADER;
+    static const std::string_view COMPACT_MARKER;
+    static const std::string_view LABEL_MARKER;
+    static const std::string_view REFS_MARKER;
+    static const std::string_view SYMBOLS_MARKER;
+    static const std::string_view LINKS_MARKER;
+    static const std::string_view LINK_SCHEMA_MARKER;
+
+    /** One Input File (Mapped or Inflated) */
+    struct Fragment {
+        ~Fragment();
+
+        const char* data = nullptr;
+        size_t size = 0;
+        void* mapping = nullptr;
+        std::string text;
+        std::string_view tuples;
+        std::string_view attributes;
+        size_t numTuples = 0;
+        size_t numInstances = 0;
+        size_t numAttributes = 0;
+        bool linked = false;
+        std::atomic<size_t> numFacts{0};
+        std::atomic<size_t> numMalformed{0};
+    };
+
+    /** Lines Parsed by One Task */
+    struct Chunk {
+        Fragment* fragment;
+        std::string_view lines;
+    };
+
+    /** Private Variables */
+    TAGraph* graph;
+    int numThreads;
+    std::vector<std::unique_ptr<Fragment>> fragments;
+    std::atomic<size_t> numFacts{0};
+    std::atomic<size_t> numResolved{0};
+    std::atomic<size_t> numUnresolved{0};
+    std::atomic<size_t> numMalformed{0};
+
+    /** Parsing Passes */
+    void parseInstances(Fragment& fragment, std::string_view lines);
+    void parseRelationships(Fragment& fragment, std::string_view lines);
+    void parseLabels(Fragment& fragment, std::string_view lines);
+    void parseCounts(Fragment& fragment, std::string_view lines);
+    void linkReferences(std::string_view links);
+    void addMalformed(Fragment& fragment, size_t malformed);
+    void runPass(bool tuples, void (TAMerge::*parse)(Fragment&, std::string_view));
+
+    /** Helper Methods */
+    bool resolve(std::string_view ID, std::string& resolved);
+    static std::string_view symbolOf(std::string_view ID);
+    static bool quotedValue(std::string_view line, std::string_view marker, std::string_view& value);
+    static bool nextLine(std::string_view& lines, std::string_view& line);
+    static bool nextToken(std::string_view& line, std::string_view& token);
+};
+
+#endif //BFX64_TAMERGE_H
@@ -0,0 +1,184 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TASQLite.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Writes a finished graph to a SQLite database instead of a TA
+// file. Nodes, reference edges, containment and symbols are bulk
+// loaded through prepared statements inside large transactions,
+// and the indexes are built once the tables are full. Only built
+// when sqlite3 is found.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <vector>
+#ifdef BFX64_SQLITE
+#include <sqlite3.h>
+#endif
+#include "TASQLite.h"
+
+using namespace std;
+
+const size_t TASQLite::ROWS_PER_TRANSACTION = 1000000;
+const string TASQLite::PRAGMAS = "PRAGMA journal_mode = OFF;\nPRAGMA synchronous = OFF;\n"
+        "PRAGMA locking_mode = EXCLUSIVE;\nPRAGMA temp_store = MEMORY;\nPRAGMA cache_size = -262144;\n";
+const string TASQLite::TABLES = "CREATE TABLE nodes (id INTEGER PRIMARY KEY, ta_id TEXT NOT NULL, type TEXT NOT NULL, "
+        "label TEXT);\nCREATE TABLE edges (src INTEGER NOT NULL, dst INTEGER NOT NULL, refs INTEGER NOT NULL);\n"
+        "CREATE TABLE contains (parent INTEGER NOT NULL, child INTEGER NOT NULL);\n"
+        "CREATE TABLE symbols (node INTEGER NOT NULL, mangled TEXT NOT NULL);\n";
+const string TASQLite::INDEXES = "CREATE UNIQUE INDEX nodes_ta_id ON nodes (ta_id);\n"
+        "CREATE INDEX nodes_label ON nodes (label);\nCREATE INDEX edges_src ON edges (src, dst);\n"
+        "CREATE INDEX edges_dst ON edges (dst, src);\nCREATE INDEX contains_parent ON contains (parent);\n"
+        "CREATE INDEX contains_child ON contains (child);\nCREATE INDEX symbols_mangled ON symbols (mangled);\n"
+        "CREATE INDEX symbols_node ON symbols (node);\nANALYZE;\n";
+
+/**
+ * Checks whether bfx64 was built with SQLite support.
+ * @return Whether databases can be written.
+ */
+bool TASQLite::isSupported(){
+#ifdef BFX64_SQLITE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Writes a finalized graph to a new SQLite database. Rows are
+ * keyed by the node's index in the frozen graph, and symbols are
+ * only there if the graph kept them when it was finalized.
+ * @param outputPath The database file, replaced if it exists.
+ * @param graph The finalized graph.
+ * @return Whether the database was written.
+ */
+bool TASQLite::writeDatabase(string outputPath, TAGraph* graph){
+#ifdef BFX64_SQLITE
+    const CSRGraph* frozen = graph->getFrozenGraph();
+    if (frozen == nullptr) return false;
+
+    //The database is rebuilt from scratch each time, so it needs no journal.
+    remove(outputPath.c_str());
+    sqlite3* db = nullptr;
+    if (sqlite3_open(outputPath.c_str(), &db) != SQLITE_OK){
+        sqlite3_close(db);
+        return false;
+    }
+
+    bool succ = execute(db, PRAGMAS) && execute(db, TABLES) && execute(db, "BEGIN;");
+    sqlite3_stmt* nodes = nullptr;
+    sqlite3_stmt* edges = nullptr;
+    sqlite3_stmt* contains = nullptr;
+    sqlite3_stmt* symbols = nullptr;
+    succ = succ && sqlite3_prepare_v2(db, "INSERT INTO nodes VALUES (?, ?, ?, ?);", -1, &nodes, nullptr) == SQLITE_OK;
+    succ = succ && sqlite3_prepare_v2(db, "INSERT INTO edges VALUES (?, ?, ?);", -1, &edges, nullptr) == SQLITE_OK;
+    succ = succ && sqlite3_prepare_v2(db, "INSERT INTO contains VALUES (?, ?);", -1, &contains, nullptr) == SQLITE_OK;
+    succ = succ && sqlite3_prepare_v2(db, "INSERT INTO symbols VALUES (?, ?);", -1, &symbols, nullptr) == SQLITE_OK;
+
+    //Each node is written with its containment and references.
+    size_t numRows = 0;
+    string ID, name;
+    for (uint32_t node = 0; succ && node < frozen->getNumNodes(); node++){
+        ID.clear();
+        frozen->appendID(ID, node);
+        const string& type = BFXNode::getTypeString(frozen->getType(node));
+        sqlite3_bind_int64(nodes, 1, node);
+        sqlite3_bind_text(nodes, 2, ID.data(), (int) ID.size(), SQLITE_STATIC);
+        sqlite3_bind_text(nodes, 3, type.data(), (int) type.size(), SQLITE_STATIC);
+        if (frozen->hasName(node)){
+            name.clear();
+            frozen->appendName(name, node);
+            sqlite3_bind_text(nodes, 4, name.data(), (int) name.size(), SQLITE_STATIC);
+        } else {
+            sqlite3_bind_null(nodes, 4);
+        }
+        succ = insertRow(db, nodes, numRows);
+
+        CSRGraph::Range children = frozen->getOutEdges(node, BFXEdge::CONTAINS);
+        for (size_t i = 0; succ && i < children.size(); i++){
+            sqlite3_bind_int64(contains, 1, node);
+            sqlite3_bind_int64(contains, 2, children.first[i]);
+            succ = insertRow(db, contains, numRows);
+        }
+
+        CSRGraph::Range dsts = frozen->getOutEdges(node, BFXEdge::LINK);
+        CSRGraph::Range counts = frozen->getOutCounts(node, BFXEdge::LINK);
+        for (size_t i = 0; succ && i < dsts.size(); i++){
+            sqlite3_bind_int64(edges, 1, node);
+            sqlite3_bind_int64(edges, 2, dsts.first[i]);
+            sqlite3_bind_int64(edges, 3, counts.first[i]);
+            succ = insertRow(db, edges, numRows);
+        }
+    }
+
+    //Symbols are kept by full ID, so each is looked up once.
+    vector<pair<string, string>> names = graph->getSymbols();
+    for (size_t i = 0; succ && i < names.size(); i++){
+        uint32_t node;
+        if (!frozen->findNode(names[i].first, node)) continue;
+
+        sqlite3_bind_int64(symbols, 1, node);
+        sqlite3_bind_text(symbols, 2, names[i].second.data(), (int) names[i].second.size(), SQLITE_STATIC);
+        succ = insertRow(db, symbols, numRows);
+    }
+
+    //Indexes are built once the tables are full.
+    sqlite3_finalize(nodes);
+    sqlite3_finalize(edges);
+    sqlite3_finalize(contains);
+    sqlite3_finalize(symbols);
+    succ = succ && execute(db, "COMMIT;") && execute(db, INDEXES);
+    return (sqlite3_close(db) == SQLITE_OK) && succ;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Runs one or more SQL statements.
+ * @param db The database.
+ * @param sql The statements.
+ * @return Whether every statement ran.
+ */
+bool TASQLite::execute(sqlite3* db, const string& sql){
+#ifdef BFX64_SQLITE
+    return sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Inserts the row bound to a prepared statement. The open
+ * transaction is committed after every so many rows.
+ * @param db The database.
+ * @param statement The bound insert.
+ * @param numRows The number of rows inserted so far.
+ * @return Whether the row was inserted.
+ */
+bool TASQLite::insertRow(sqlite3* db, sqlite3_stmt* statement, size_t& numRows){
+#ifdef BFX64_SQLITE
+    bool succ = sqlite3_step(statement) == SQLITE_DONE;
+    sqlite3_reset(statement);
+    if (succ && ++numRows % ROWS_PER_TRANSACTION == 0) succ = execute(db, "COMMIT; BEGIN;");
+    return succ;
+#else
+    return false;
+#endif
+}
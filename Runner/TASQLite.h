@@ -0,0 +1,58 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TASQLite.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Writes a finished graph to a SQLite database instead of a TA
+// file. Nodes, reference edges, containment and symbols are bulk
+// loaded through prepared statements inside large transactions,
+// and the indexes are built once the tables are full. Only built
+// when sqlite3 is found.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_TASQLITE_H
+#define BFX64_TASQLITE_H
+
+#include <string>
+#include "../Graph/TAGraph.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+class TASQLite {
+public:
+    /** Export Methods */
+    static bool isSupported();
+    static bool writeDatabase(std::string outputPath, TAGraph* graph);
+
+private:
+    /** Rows Inserted per Transaction */
+    static const size_t ROWS_PER_TRANSACTION;
+
+    /** Database Layout */
+    static const std::string PRAGMAS;
+    static const std::string TABLES;
+    static const std::string INDEXES;
+
+    /** Helper Methods */
+    static bool execute(sqlite3* db, const std::string& sql);
+    static bool insertRow(sqlite3* db, sqlite3_stmt* statement, size_t& numRows);
+};
+
+#endif //BFX64_TASQLITE_H
@@ -0,0 +1,425 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TASpill.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Out-of-core TA writer for low memory mode. Every purge of the
+// graph writes sorted runs of instances, relationships and attributes
+// to a temporary directory. At the end, the runs are k-way merged and
+// deduplicated into a single, well-formed TA file.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <thread>
+#include "TASpill.h"
+
+using namespace std;
+using namespace boost::filesystem;
+
+const int TASpill::MERGE_FANIN = 64;
+const size_t TASpill::INDEX_STRIDE = 64;
+const size_t TASpill::MIN_SORT_LINES = 65536;
+const string TASpill::INSTANCE_PREFIX = "$INSTANCE ";
+const string TASpill::COUNT_MARKER = ") { refs = ";
+const string TASpill::COUNT_END = " }";
+
+/** Section File Suffixes */
+static const char* SECTION_SUFFIX[TASpill::NUM_SECTIONS] = {"inst", "rel", "att"};
+
+/**
+ * Creates a spill writer for a TA file.
+ * @param outputPath The final TA file location.
+ * @param codec The codec the TA file is compressed with.
+ * @param level The compression level.
+ */
+TASpill::TASpill(string outputPath, TACodec::Codec codec, int level){
+    this->outputPath = outputPath;
+    this->codec = codec;
+    this->level = level;
+    this->runCounter = 0;
+    this->numThreads = 1;
+}
+
+/**
+ * Destructor. Removes any temporary runs left behind.
+ */
+TASpill::~TASpill(){
+    cleanup();
+}
+
+/**
+ * Creates the temporary directory that holds the runs.
+ * @return Whether the directory could be created.
+ */
+bool TASpill::start(){
+    boost::system::error_code ec;
+    spillDir = temp_directory_path(ec);
+    if (ec) return false;
+
+    spillDir /= unique_path("bfx64-spill-%%%%-%%%%-%%%%");
+    create_directories(spillDir, ec);
+    return !ec;
+}
+
+/**
+ * Writes the current contents of the graph as one sorted
+ * run per TA section.
+ * @param graph The graph to spill.
+ * @return Whether the runs were written.
+ */
+bool TASpill::spill(TAGraph* graph){
+    if (!writeRun(INSTANCES, graph->printInstances())) return false;
+    if (!writeRun(RELATIONSHIPS, graph->printRelationships())) return false;
+    return writeRun(ATTRIBUTES, graph->printAttributes());
+}
+
+/**
+ * Adds lines that weren't spilled from a graph as a new run.
+ * @param section The section the lines belong to.
+ * @param lines The newline separated lines.
+ * @return Whether the run was written.
+ */
+bool TASpill::addRun(Section section, const string& lines){
+    return writeRun(section, lines);
+}
+
+/**
+ * Merges all runs into the final TA file.
+ * @param header The schema written before the facts.
+ * @return Whether the TA file was written.
+ */
+bool TASpill::finish(const string& header){
+    //Lookups are done once we start merging.
+    instanceIndex.clear();
+
+    //Bring every section down to a single merge pass.
+    for (int i = 0; i < NUM_SECTIONS; i++){
+        if (!reduceRuns((Section) i)) return false;
+    }
+
+    TAOutStream taFile(outputPath, codec, level);
+    if (!taFile.isOpen()) return false;
+
+    taFile << header;
+    taFile << "FACT TUPLE :\n";
+    if (!mergeRuns(runs[INSTANCES], taFile)) return false;
+    if (!mergeRuns(runs[RELATIONSHIPS], taFile)) return false;
+
+    taFile << "\nFACT ATTRIBUTE :\n";
+    if (!mergeRuns(runs[ATTRIBUTES], taFile)) return false;
+
+    cleanup();
+    return taFile.close();
+}
+
+/**
+ * Checks whether a node was spilled to any instance run. Uses
+ * the sparse index to read a single block of each run. Several
+ * threads can check at once as long as no run is being added.
+ * @param ID The node ID to look for.
+ * @return Boolean indicating whether the node was spilled.
+ */
+bool TASpill::containsInstance(string_view ID){
+    string prefix = INSTANCE_PREFIX;
+    prefix += ID;
+    prefix += ' ';
+
+    for (size_t i = 0; i < instanceIndex.size(); i++){
+        const RunIndex& index = instanceIndex[i];
+        if (index.keys.size() == 0) continue;
+
+        //Find the block that would hold the line.
+        size_t block = (size_t) (upper_bound(index.keys.begin(), index.keys.end(), prefix) - index.keys.begin());
+        if (block > 0) block--;
+
+        std::ifstream run(runs[INSTANCES][i].string().c_str(), ios::binary);
+        if (!run.is_open()) continue;
+        run.seekg((streamoff) index.offsets[block]);
+
+        //The line is in this block or starts the next one.
+        string line;
+        for (size_t read = 0; read <= INDEX_STRIDE && getline(run, line); read++){
+            if (line.compare(0, prefix.size(), prefix) == 0) return true;
+            if (line > prefix) break;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Gets the number of runs waiting to be merged.
+ * @return The number of runs.
+ */
+int TASpill::getNumRuns(){
+    size_t total = 0;
+    for (int i = 0; i < NUM_SECTIONS; i++) total += runs[i].size();
+    return (int) total;
+}
+
+/**
+ * Sets the number of threads used to sort each run.
+ * @param numThreads The number of threads (0 uses every core).
+ */
+void TASpill::setNumThreads(int numThreads){
+    if (numThreads <= 0) numThreads = (int) thread::hardware_concurrency();
+    this->numThreads = (numThreads <= 0) ? 1 : numThreads;
+}
+
+/**
+ * Sorts the lines of a section and writes them out as a run.
+ * Lines are sorted by reference into the section string so
+ * no line is copied.
+ * @param section The section the lines belong to.
+ * @param lines The newline separated lines.
+ * @return Whether the run was written.
+ */
+bool TASpill::writeRun(Section section, const string& lines){
+    if (lines.size() == 0) return true;
+
+    //Index the start and length of every line.
+    vector<pair<size_t, size_t>> index;
+    size_t start = 0;
+    while (start < lines.size()){
+        size_t end = lines.find('\n', start);
+        if (end == string::npos) end = lines.size();
+        if (end > start) index.push_back(make_pair(start, end - start));
+        start = end + 1;
+    }
+
+    const char* data = lines.data();
+    sortLines(index, data);
+
+    //Write the run, dropping duplicates.
+    path runPath = nextRunPath(section);
+    std::ofstream run(runPath.string().c_str(), ios::binary);
+    if (!run.is_open()) return false;
+
+    RunIndex sparse;
+    uint64_t offset = 0;
+    size_t written = 0;
+    for (size_t i = 0; i < index.size(); i++){
+        if (i > 0 && index[i].second == index[i - 1].second &&
+                memcmp(data + index[i].first, data + index[i - 1].first, index[i].second) == 0) continue;
+
+        //Instance runs keep every few lines for lookups.
+        if (section == INSTANCES && written++ % INDEX_STRIDE == 0){
+            sparse.keys.push_back(string(data + index[i].first, index[i].second));
+            sparse.offsets.push_back(offset);
+        }
+
+        run.write(data + index[i].first, index[i].second);
+        run.put('\n');
+        offset += index[i].second + 1;
+    }
+    run.close();
+    if (run.fail()) return false;
+
+    runs[section].push_back(runPath);
+    if (section == INSTANCES) instanceIndex.push_back(sparse);
+    return true;
+}
+
+/**
+ * Sorts line references by the bytes of their lines. Large runs
+ * are split into equal parts sorted on their own threads, then
+ * merged pairwise, also in parallel. Equal lines are identical,
+ * so the result doesn't depend on the number of threads.
+ * @param index The start and length of every line.
+ * @param data The text the lines are in.
+ */
+void TASpill::sortLines(vector<pair<size_t, size_t>>& index, const char* data){
+    auto less = [data](const pair<size_t, size_t>& a, const pair<size_t, size_t>& b){
+        int cmp = memcmp(data + a.first, data + b.first, min(a.second, b.second));
+        return (cmp != 0) ? cmp < 0 : a.second < b.second;
+    };
+
+    size_t parts = min((size_t) numThreads, index.size() / MIN_SORT_LINES);
+    if (parts <= 1){
+        sort(index.begin(), index.end(), less);
+        return;
+    }
+
+    //Sort each part on its own thread.
+    vector<size_t> bounds(parts + 1);
+    for (size_t i = 0; i <= parts; i++) bounds[i] = index.size() * i / parts;
+
+    vector<thread> threads;
+    for (size_t i = 0; i < parts; i++){
+        threads.push_back(thread([&index, &bounds, &less, i](){
+            sort(index.begin() + bounds[i], index.begin() + bounds[i + 1], less);
+        }));
+    }
+    for (thread& curr : threads) curr.join();
+
+    //Merge neighbouring parts until one is left.
+    for (size_t width = 1; width < parts; width *= 2){
+        threads.clear();
+        for (size_t i = 0; i + width < parts; i += width * 2){
+            size_t mid = bounds[i + width];
+            size_t end = bounds[min(i + width * 2, parts)];
+            threads.push_back(thread([&index, &less, i, mid, end, &bounds](){
+                inplace_merge(index.begin() + bounds[i], index.begin() + mid, index.begin() + end, less);
+            }));
+        }
+        for (thread& curr : threads) curr.join();
+    }
+}
+
+/**
+ * Performs a k-way merge of sorted runs, writing each distinct
+ * line once. An edge can be counted in several runs, so counted
+ * attribute lines for the same edge are summed into one line.
+ * Lines for one edge share a prefix and so are adjacent.
+ * @param inputs The runs to merge.
+ * @param out The stream to write to.
+ * @return Whether the merge succeeded.
+ */
+bool TASpill::mergeRuns(const vector<path>& inputs, ostream& out){
+    vector<unique_ptr<std::ifstream>> streams;
+    vector<string> heads(inputs.size());
+
+    //Min-heap on the current line of each run.
+    auto greater = [&heads](size_t a, size_t b){ return heads[a] > heads[b]; };
+    priority_queue<size_t, vector<size_t>, decltype(greater)> heap(greater);
+
+    for (size_t i = 0; i < inputs.size(); i++){
+        streams.push_back(unique_ptr<std::ifstream>(new std::ifstream(inputs[i].string().c_str(), ios::binary)));
+        if (!streams[i]->is_open()) return false;
+        if (getline(*streams[i], heads[i])) heap.push(i);
+    }
+
+    string last;
+    bool first = true;
+    string countKey;
+    uint64_t total = 0;
+    auto flushCount = [&out, &countKey, &total](){
+        if (countKey.empty()) return;
+        out << countKey << COUNT_MARKER.substr(1) << total << COUNT_END << '\n';
+        countKey.clear();
+    };
+
+    while (!heap.empty()){
+        size_t curr = heap.top();
+        heap.pop();
+
+        //Sum the counts of the same edge.
+        size_t keyLength;
+        uint64_t count;
+        if (splitCount(heads[curr], keyLength, count)){
+            if (countKey.size() != keyLength || heads[curr].compare(0, keyLength, countKey) != 0){
+                flushCount();
+                countKey = heads[curr].substr(0, keyLength);
+                total = 0;
+            }
+            total += count;
+        } else {
+            flushCount();
+            if (first || heads[curr] != last){
+                out << heads[curr] << '\n';
+                last = heads[curr];
+                first = false;
+            }
+        }
+
+        if (getline(*streams[curr], heads[curr])) heap.push(curr);
+    }
+    flushCount();
+
+    return !out.fail();
+}
+
+/**
+ * Merges runs of a section in batches until at most
+ * MERGE_FANIN remain, keeping open files bounded.
+ * @param section The section to reduce.
+ * @return Whether the reduction succeeded.
+ */
+bool TASpill::reduceRuns(Section section){
+    while (runs[section].size() > (size_t) MERGE_FANIN){
+        vector<path> batch(runs[section].begin(), runs[section].begin() + MERGE_FANIN);
+        path merged = nextRunPath(section);
+
+        std::ofstream out(merged.string().c_str(), ios::binary);
+        if (!out.is_open() || !mergeRuns(batch, out)) return false;
+        out.close();
+
+        //Replace the batch with the merged run.
+        boost::system::error_code ec;
+        for (path const& curr : batch) boost::filesystem::remove(curr, ec);
+        runs[section].erase(runs[section].begin(), runs[section].begin() + MERGE_FANIN);
+        runs[section].push_back(merged);
+    }
+
+    return true;
+}
+
+/**
+ * Splits a counted edge attribute line into its edge and count.
+ * @param line The attribute line.
+ * @param keyLength The length of the edge part, up to the closing bracket.
+ * @param count The count on the line.
+ * @return Whether the line is a counted edge attribute.
+ */
+bool TASpill::splitCount(const string& line, size_t& keyLength, uint64_t& count){
+    if (line.empty() || line[0] != '(' || line.size() < COUNT_MARKER.size() + COUNT_END.size()) return false;
+    if (line.compare(line.size() - COUNT_END.size(), COUNT_END.size(), COUNT_END) != 0) return false;
+
+    size_t marker = line.rfind(COUNT_MARKER);
+    if (marker == string::npos) return false;
+
+    //The count sits between the marker and the end.
+    size_t start = marker + COUNT_MARKER.size();
+    size_t end = line.size() - COUNT_END.size();
+    if (start >= end) return false;
+
+    count = 0;
+    for (size_t i = start; i < end; i++){
+        if (line[i] < '0' || line[i] > '9') return false;
+        count = count * 10 + (uint64_t) (line[i] - '0');
+    }
+    keyLength = marker + 1;
+    return true;
+}
+
+/**
+ * Generates the path of the next run file.
+ * @param section The section of the run.
+ * @return The run path.
+ */
+path TASpill::nextRunPath(Section section){
+    return spillDir / ("run" + to_string(runCounter++) + "." + SECTION_SUFFIX[section]);
+}
+
+/**
+ * Removes the temporary directory and all runs.
+ */
+void TASpill::cleanup(){
+    if (spillDir.empty()) return;
+
+    boost::system::error_code ec;
+    remove_all(spillDir, ec);
+    spillDir = path();
+    for (int i = 0; i < NUM_SECTIONS; i++) runs[i].clear();
+    instanceIndex.clear();
+}
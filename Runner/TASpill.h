@@ -0,0 +1,103 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TASpill.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Out-of-core TA writer for low memory mode. Every purge of the
+// graph writes sorted runs of instances, relationships and attributes
+// to a temporary directory. At the end, the runs are k-way merged and
+// deduplicated into a single, well-formed TA file.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_TASPILL_H
+#define BFX64_TASPILL_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include "../Graph/TAGraph.h"
+#include "TAStream.h"
+
+class TASpill {
+public:
+    /** Sections of a TA File */
+    enum Section { INSTANCES, RELATIONSHIPS, ATTRIBUTES };
+    static const int NUM_SECTIONS = 3;
+
+    /** Constructor / Destructor */
+    TASpill(std::string outputPath, TACodec::Codec codec = TACodec::NONE, int level = 0);
+    ~TASpill();
+
+    /** Spill Operations */
+    bool start();
+    bool spill(TAGraph* graph);
+    bool addRun(Section section, const std::string& lines);
+    bool finish(const std::string& header);
+
+    /** Lookup Methods */
+    bool containsInstance(std::string_view ID);
+
+    /** Getters / Setters */
+    int getNumRuns();
+    void setNumThreads(int numThreads);
+
+private:
+    /** Maximum Runs Merged at Once */
+    static const int MERGE_FANIN;
+
+    /** Lines Between Sparse Index Entries */
+    static const size_t INDEX_STRIDE;
+
+    /** Fewest Lines Each Sorting Thread Takes */
+    static const size_t MIN_SORT_LINES;
+    static const std::string INSTANCE_PREFIX;
+
+    /** Counted Edge Attributes (Summed When Merged) */
+    static const std::string COUNT_MARKER;
+    static const std::string COUNT_END;
+
+    /** Sparse Index Over a Sorted Run */
+    struct RunIndex {
+        std::vector<std::string> keys;
+        std::vector<uint64_t> offsets;
+    };
+
+    /** Private Variables */
+    std::string outputPath;
+    TACodec::Codec codec;
+    int level;
+    boost::filesystem::path spillDir;
+    std::vector<boost::filesystem::path> runs[NUM_SECTIONS];
+    std::vector<RunIndex> instanceIndex;
+    int runCounter;
+    int numThreads;
+
+    /** Helper Methods */
+    bool writeRun(Section section, const std::string& lines);
+    void sortLines(std::vector<std::pair<size_t, size_t>>& index, const char* data);
+    bool mergeRuns(const std::vector<boost::filesystem::path>& inputs, std::ostream& out);
+    bool reduceRuns(Section section);
+    static bool splitCount(const std::string& line, size_t& keyLength, uint64_t& count);
+    boost::filesystem::path nextRunPath(Section section);
+    void cleanup();
+};
+
+#endif //BFX64_TASPILL_H
@@ -0,0 +1,329 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TASplit.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Writes a finished graph as one TA file per subsystem. Subsystems
+// at a chosen depth below the top of the containment tree each get
+// a file holding everything they contain, and edges that cross from
+// one subsystem to another go to a separate file along with stub
+// instances of their endpoints. Files are written concurrently.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <boost/filesystem.hpp>
+#include "../Graph/TASink.h"
+#include "TASpill.h"
+#include "TASplit.h"
+
+using namespace std;
+
+const string TASplit::TOP_NAME = "_top";
+const string TASplit::CROSS_NAME = "_cross";
+const string TASplit::ROOT_NAME = "_root";
+const string TASplit::SPLIT_KIND = "subsystem";
+const uint32_t TASplit::NO_PART = UINT32_MAX;
+const size_t TASplit::SORT_RUN_BYTES = 16 * 1024 * 1024;
+
+/**
+ * Creates a splitter over a finalized graph and works out which
+ * file every node goes to.
+ * @param graph The finalized graph.
+ * @param depth The subsystem depth to split at (1 for the top-level subsystems).
+ * @param numThreads The number of writer threads (0 uses every core).
+ */
+TASplit::TASplit(TAGraph* graph, int depth, int numThreads){
+    this->graph = graph;
+    this->frozen = graph->getFrozenGraph();
+    this->depth = depth;
+    if (numThreads <= 0) numThreads = (int) thread::hardware_concurrency();
+    this->numThreads = (numThreads <= 0) ? 1 : numThreads;
+
+    if (frozen != nullptr) assignParts();
+}
+
+/**
+ * Default destructor.
+ */
+TASplit::~TASplit(){ }
+
+/**
+ * Writes every subsystem's TA file and the file of crossing edges
+ * into a directory. Subsystems below the top level are written
+ * into subdirectories named after their parents.
+ * @param outputDir The directory to write to, created if needed.
+ * @param schema The schema each file starts with.
+ * @param codec The codec to compress each file with.
+ * @param level The compression level.
+ * @param sorted Whether each section is sorted line by line.
+ * @return Whether every file was written.
+ */
+bool TASplit::write(string outputDir, const string& schema, TACodec::Codec codec, int level, bool sorted){
+    if (frozen == nullptr) return false;
+
+    //Stubs are the endpoints of edges between files.
+    Part cross{CROSS_NAME, vector<uint32_t>()};
+    vector<bool> stub(frozen->getNumNodes(), false);
+    for (uint32_t src = 0; src < (uint32_t) frozen->getNumNodes(); src++){
+        for (int type = 0; type < CSRGraph::EDGE_TYPES; type++){
+            for (uint32_t dst : frozen->getOutEdges(src, (BFXEdge::EdgeType) type)){
+                if (partOf[src] == partOf[dst]) continue;
+                stub[src] = true;
+                stub[dst] = true;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < (uint32_t) stub.size(); i++){
+        if (stub[i]) cross.nodes.push_back(i);
+    }
+
+    //Directories are made up front so the writers never race on them.
+    boost::system::error_code error;
+    boost::filesystem::path dir(outputDir);
+    vector<pair<string, uint32_t>> jobs;
+    for (uint32_t i = 0; i < (uint32_t) parts.size(); i++){
+        if (parts[i].nodes.empty()) continue;
+
+        boost::filesystem::path file = dir / (parts[i].name + ".ta");
+        boost::filesystem::create_directories(file.parent_path(), error);
+        if (error) return false;
+        jobs.push_back(make_pair(TACodec::addExtension(file.string(), codec), i));
+    }
+    boost::filesystem::create_directories(dir, error);
+    if (error) return false;
+    jobs.push_back(make_pair(TACodec::addExtension((dir / (CROSS_NAME + ".ta")).string(), codec), NO_PART));
+
+    //The largest files are started first to balance the writers.
+    sort(jobs.begin(), jobs.end(), [this, &cross](const pair<string, uint32_t>& a, const pair<string, uint32_t>& b){
+        size_t aSize = (a.second == NO_PART) ? cross.nodes.size() : parts[a.second].nodes.size();
+        size_t bSize = (b.second == NO_PART) ? cross.nodes.size() : parts[b.second].nodes.size();
+        return aSize > bSize || (aSize == bSize && a.first < b.first);
+    });
+
+    atomic<size_t> next{0};
+    atomic<bool> succ{true};
+    auto worker = [&](){
+        for (size_t i = next++; i < jobs.size(); i = next++){
+            const Part& part = (jobs[i].second == NO_PART) ? cross : parts[jobs[i].second];
+            if (!writePart(jobs[i].first, part, jobs[i].second, schema, codec, level, sorted)) succ = false;
+        }
+    };
+
+    size_t workers = min((size_t) numThreads, jobs.size());
+    if (workers <= 1){
+        worker();
+        return succ;
+    }
+
+    vector<thread> threads;
+    for (size_t i = 0; i < workers; i++) threads.push_back(thread(worker));
+    for (thread& curr : threads) curr.join();
+    return succ;
+}
+
+/**
+ * Gets the number of subsystem files, not counting the file of
+ * crossing edges.
+ * @return The number of non-empty splits.
+ */
+size_t TASplit::getNumSplits() const {
+    size_t numSplits = 0;
+    for (const Part& part : parts){
+        if (!part.nodes.empty()) numSplits++;
+    }
+    return numSplits;
+}
+
+/**
+ * Parses a split such as "subsystem" or "subsystem:2".
+ * @param spec The split to parse.
+ * @param depth The subsystem depth, 1 if not given.
+ * @return Whether the split is valid.
+ */
+bool TASplit::parseSplit(const string& spec, int& depth){
+    if (spec.compare(0, SPLIT_KIND.size(), SPLIT_KIND) != 0) return false;
+
+    string rest = spec.substr(SPLIT_KIND.size());
+    if (rest.empty()){
+        depth = 1;
+        return true;
+    }
+    if (rest[0] != ':' || rest.size() == 1 || rest.size() > 4) return false;
+
+    depth = 0;
+    for (size_t i = 1; i < rest.size(); i++){
+        if (rest[i] < '0' || rest[i] > '9') return false;
+        depth = depth * 10 + (rest[i] - '0');
+    }
+    return depth > 0;
+}
+
+/**
+ * Works out the file every node goes to. The top of the tree is
+ * the root subsystem, skipping directories that only hold one
+ * subdirectory. Subsystems down to the chosen depth below it get
+ * a file each and everything else goes with its container.
+ */
+void TASplit::assignParts(){
+    size_t numNodes = frozen->getNumNodes();
+    partOf.assign(numNodes, NO_PART);
+    parts.clear();
+    parts.push_back(Part{TOP_NAME, vector<uint32_t>()});
+
+    auto subsystems = [this](uint32_t node){
+        vector<uint32_t> children;
+        for (uint32_t child : frozen->getOutEdges(node, BFXEdge::CONTAINS)){
+            if (frozen->getType(child) == BFXNode::SUBSYSTEM) children.push_back(child);
+        }
+        return children;
+    };
+
+    vector<uint32_t> level;
+    for (uint32_t i = 0; i < (uint32_t) numNodes; i++){
+        if (frozen->getType(i) == BFXNode::SUBSYSTEM && frozen->getInEdges(i, BFXEdge::CONTAINS).size() == 0){
+            level.push_back(i);
+        }
+    }
+
+    //A single root is walked down to where the tree branches.
+    string topID;
+    if (level.size() == 1){
+        uint32_t top = level[0];
+        CSRGraph::Range children = frozen->getOutEdges(top, BFXEdge::CONTAINS);
+        while (children.size() == 1 && frozen->getType(children.first[0]) == BFXNode::SUBSYSTEM){
+            partOf[top] = 0;
+            top = children.first[0];
+            children = frozen->getOutEdges(top, BFXEdge::CONTAINS);
+        }
+        partOf[top] = 0;
+        topID = frozen->getID(top);
+        level = subsystems(top);
+    }
+
+    for (int curr = 1; curr <= depth && !level.empty(); curr++){
+        vector<uint32_t> next;
+        for (uint32_t subsystem : level){
+            partOf[subsystem] = (uint32_t) parts.size();
+            parts.push_back(Part{getPartName(subsystem, topID), vector<uint32_t>()});
+            if (curr == depth) continue;
+
+            vector<uint32_t> children = subsystems(subsystem);
+            next.insert(next.end(), children.begin(), children.end());
+        }
+        level = next;
+    }
+
+    for (uint32_t i = 0; i < (uint32_t) numNodes; i++) parts[findPart(i)].nodes.push_back(i);
+}
+
+/**
+ * Finds the file a node goes to by walking up its containers
+ * to one that has been placed. Every node passed is placed too.
+ * Nodes with no placed container go in the top file.
+ * @param node The node index.
+ * @return The part index.
+ */
+uint32_t TASplit::findPart(uint32_t node){
+    vector<uint32_t> chain;
+    uint32_t curr = node;
+    while (partOf[curr] == NO_PART && chain.size() <= partOf.size()){
+        chain.push_back(curr);
+        CSRGraph::Range parents = frozen->getInEdges(curr, BFXEdge::CONTAINS);
+        if (parents.size() == 0) break;
+        curr = parents.first[0];
+    }
+
+    uint32_t part = (partOf[curr] == NO_PART) ? 0 : partOf[curr];
+    for (uint32_t placed : chain) partOf[placed] = part;
+    return part;
+}
+
+/**
+ * Gets the file name of a subsystem: its path below the top of
+ * the tree, so nested subsystems land in subdirectories.
+ * @param subsystem The subsystem node.
+ * @param topID The ID of the top of the tree, if there is one.
+ * @return The file name, without an extension.
+ */
+string TASplit::getPartName(uint32_t subsystem, const string& topID) const {
+    string ID = frozen->getID(subsystem);
+    string name = (!topID.empty() && ID.compare(0, topID.size(), topID) == 0) ? ID.substr(topID.size()) : ID;
+
+    size_t start = name.find_first_not_of('/');
+    return (start == string::npos) ? ROOT_NAME : name.substr(start);
+}
+
+/**
+ * Writes one TA file. A subsystem's file keeps the edges between
+ * its own nodes; the crossing file keeps every other edge. Sections
+ * are streamed to the file as they're generated, or cut into sorted
+ * runs and merged into it when sorted.
+ * @param file The file to write.
+ * @param part The nodes to write.
+ * @param index The part index, or NO_PART for the crossing file.
+ * @param schema The schema the file starts with.
+ * @param codec The codec to compress with.
+ * @param level The compression level.
+ * @param sorted Whether each section is sorted line by line.
+ * @return Whether the file was written.
+ */
+bool TASplit::writePart(const string& file, const Part& part, uint32_t index, const string& schema,
+                        TACodec::Codec codec, int level, bool sorted){
+    function<bool(uint32_t, uint32_t)> keepEdge = [this, index](uint32_t src, uint32_t dst){
+        return (index == NO_PART) ? partOf[src] != partOf[dst] : partOf[dst] == index;
+    };
+
+    if (sorted){
+        TASpill spill(file, codec, level);
+        if (!spill.start()) return false;
+
+        for (int i = 0; i < TASpill::NUM_SECTIONS; i++){
+            TASpill::Section section = (TASpill::Section) i;
+            TASink sink([&spill, section](const string& lines){
+                return spill.addRun(section, lines);
+            }, SORT_RUN_BYTES);
+
+            if (section == TASpill::INSTANCES){
+                graph->printSubgraphInstances(sink, part.nodes);
+            } else if (section == TASpill::RELATIONSHIPS){
+                graph->printSubgraphRelationships(sink, part.nodes, keepEdge);
+            } else {
+                graph->printSubgraphAttributes(sink, part.nodes, keepEdge);
+            }
+            if (!sink.flush()) return false;
+        }
+        return spill.finish(schema);
+    }
+
+    TAOutStream taFile(file, codec, level);
+    if (!taFile.isOpen()) return false;
+
+    TASink sink(taFile);
+    sink.append(schema);
+    sink.append("FACT TUPLE :\n");
+    graph->printSubgraphInstances(sink, part.nodes);
+    graph->printSubgraphRelationships(sink, part.nodes, keepEdge);
+    sink.append("\nFACT ATTRIBUTE :\n");
+    graph->printSubgraphAttributes(sink, part.nodes, keepEdge);
+
+    bool succ = sink.flush();
+    return taFile.close() && succ;
+}
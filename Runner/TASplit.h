@@ -0,0 +1,86 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TASplit.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Writes a finished graph as one TA file per subsystem. Subsystems
+// at a chosen depth below the top of the containment tree each get
+// a file holding everything they contain, and edges that cross from
+// one subsystem to another go to a separate file along with stub
+// instances of their endpoints. Files are written concurrently.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_TASPLIT_H
+#define BFX64_TASPLIT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Graph/TAGraph.h"
+#include "TAStream.h"
+
+class TASplit {
+public:
+    /** Constructor / Destructor */
+    TASplit(TAGraph* graph, int depth, int numThreads = 1);
+    ~TASplit();
+
+    /** Split Operations */
+    bool write(std::string outputDir, const std::string& schema, TACodec::Codec codec, int level, bool sorted);
+
+    /** Getters */
+    size_t getNumSplits() const;
+
+    /** Option Parsing */
+    static bool parseSplit(const std::string& spec, int& depth);
+
+private:
+    /** Reserved File Names (Above the Chosen Depth, Crossing Edges, Root) */
+    static const std::string TOP_NAME;
+    static const std::string CROSS_NAME;
+    static const std::string ROOT_NAME;
+    static const std::string SPLIT_KIND;
+    static const uint32_t NO_PART;
+
+    /** Bytes per Sorted Run (Each Writer Fills Its Own) */
+    static const size_t SORT_RUN_BYTES;
+
+    /** One Output File */
+    struct Part {
+        std::string name;
+        std::vector<uint32_t> nodes;
+    };
+
+    /** Private Variables */
+    TAGraph* graph;
+    const CSRGraph* frozen;
+    int depth;
+    int numThreads;
+    std::vector<uint32_t> partOf;
+    std::vector<Part> parts;
+
+    /** Helper Methods */
+    void assignParts();
+    uint32_t findPart(uint32_t node);
+    std::string getPartName(uint32_t subsystem, const std::string& topID) const;
+    bool writePart(const std::string& file, const Part& part, uint32_t index, const std::string& schema,
+                   TACodec::Codec codec, int level, bool sorted);
+};
+
+#endif //BFX64_TASPLIT_H
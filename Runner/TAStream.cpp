@@ -0,0 +1,587 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TAStream.cpp
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Optionally compressed TA file streams. Output is handed to a
+// background thread in large blocks that compresses it with gzip
+// or zstd and writes it out, so formatting never waits on the
+// compressor. Input detects the format from the first bytes of
+// the file and decompresses it on the fly.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include "TAStream.h"
+
+using namespace std;
+
+/**
+ * Parses a compression setting such as "gzip", "zstd" or "gzip:9".
+ * @param spec The setting to parse.
+ * @param codec The codec that was named.
+ * @param level The compression level, or the codec's default.
+ * @return Whether the setting is valid.
+ */
+bool TACodec::parse(string spec, Codec& codec, int& level){
+    size_t colon = spec.find(':');
+    string name = spec.substr(0, colon);
+
+    int maxLevel;
+    if (name.compare("gzip") == 0 || name.compare("gz") == 0){
+        codec = GZIP;
+        level = GZIP_DEFAULT_LEVEL;
+        maxLevel = 9;
+    } else if (name.compare("zstd") == 0 || name.compare("zst") == 0){
+        codec = ZSTD;
+        level = ZSTD_DEFAULT_LEVEL;
+        maxLevel = 22;
+    } else if (name.compare("none") == 0){
+        codec = NONE;
+        level = 0;
+        return colon == string::npos;
+    } else {
+        return false;
+    }
+
+    //Check for an explicit level.
+    if (colon == string::npos) return true;
+    string digits = spec.substr(colon + 1);
+    if (digits.empty() || digits.size() > 2 || digits.find_first_not_of("0123456789") != string::npos) return false;
+
+    level = stoi(digits);
+    return level >= 1 && level <= maxLevel;
+}
+
+/**
+ * Checks whether bfx64 was built with a codec.
+ * @param codec The codec to check.
+ * @return Boolean indicating whether it can be used.
+ */
+bool TACodec::isSupported(Codec codec){
+    if (codec != ZSTD) return true;
+#ifdef BFX64_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Gets the file extension of a codec.
+ * @param codec The codec.
+ * @return The extension, including the dot.
+ */
+string TACodec::getExtension(Codec codec){
+    if (codec == GZIP) return ".gz";
+    if (codec == ZSTD) return ".zst";
+    return "";
+}
+
+/**
+ * Gets the name of a codec.
+ * @param codec The codec.
+ * @return The name.
+ */
+string TACodec::getName(Codec codec){
+    if (codec == GZIP) return "gzip";
+    if (codec == ZSTD) return "zstd";
+    return "none";
+}
+
+/**
+ * Adds the extension of a codec to a path unless it's
+ * already there.
+ * @param path The path.
+ * @param codec The codec.
+ * @return The path with the extension.
+ */
+string TACodec::addExtension(string path, Codec codec){
+    string ext = getExtension(codec);
+    if (path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0) return path;
+    return path + ext;
+}
+
+/**
+ * Opens a file for compressed output and starts the
+ * compressor thread.
+ * @param path The file to write.
+ * @param codec The codec to compress with.
+ * @param level The compression level.
+ */
+CompressBuffer::CompressBuffer(string path, TACodec::Codec codec, int level){
+    this->codec = codec;
+    this->busy = false;
+    this->done = false;
+    this->failed = false;
+    memset(&gzip, 0, sizeof(gzip));
+#ifdef BFX64_ZSTD
+    this->zstd = nullptr;
+#endif
+
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return;
+
+    //Sets up the compressor.
+    bool ready = true;
+    if (codec == TACodec::GZIP){
+        //Window bits past 15 ask zlib for a gzip header.
+        ready = deflateInit2(&gzip, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    } else if (codec == TACodec::ZSTD){
+#ifdef BFX64_ZSTD
+        zstd = ZSTD_createCCtx();
+        ready = zstd != nullptr && !ZSTD_isError(ZSTD_CCtx_setParameter(zstd, ZSTD_c_compressionLevel, level));
+#else
+        ready = false;
+#endif
+    }
+    if (!ready){
+        fclose(file);
+        file = nullptr;
+        return;
+    }
+
+    if (codec != TACodec::NONE) encoded.resize(BLOCK_SIZE / 4);
+    block.resize(BLOCK_SIZE);
+    setp(block.data(), block.data() + block.size());
+    compressor = thread(&CompressBuffer::compressLoop, this);
+}
+
+/**
+ * Destructor. Finishes the file if it wasn't closed.
+ */
+CompressBuffer::~CompressBuffer(){
+    if (file != nullptr) close();
+}
+
+/**
+ * Checks whether the file was opened.
+ * @return Boolean indicating whether the file is open.
+ */
+bool CompressBuffer::isOpen() const {
+    return file != nullptr;
+}
+
+/**
+ * Writes out everything that's buffered, ends the compressed
+ * stream and closes the file.
+ * @return Whether everything was written.
+ */
+bool CompressBuffer::close(){
+    if (file == nullptr) return false;
+
+    bool succ = handOff();
+    {
+        lock_guard<mutex> guard(lock);
+        done = true;
+    }
+    changed.notify_all();
+    compressor.join();
+
+    //The compressor is gone, so the stream is ended here.
+    encode(nullptr, 0, true);
+    if (codec == TACodec::GZIP) deflateEnd(&gzip);
+#ifdef BFX64_ZSTD
+    ZSTD_freeCCtx(zstd);
+    zstd = nullptr;
+#endif
+
+    if (fclose(file) != 0) failed = true;
+    file = nullptr;
+    setp(nullptr, nullptr);
+    return succ && !failed;
+}
+
+/**
+ * Called when the block is full. Queues it and starts a new one.
+ * @param c The character that didn't fit.
+ * @return The character, or EOF on failure.
+ */
+int CompressBuffer::overflow(int c){
+    if (!handOff()) return traits_type::eof();
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())){
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+/**
+ * Waits until everything written so far has reached the file.
+ * @return Zero on success, -1 on failure.
+ */
+int CompressBuffer::sync(){
+    if (!handOff() || !drain()) return -1;
+    return (fflush(file) == 0) ? 0 : -1;
+}
+
+/**
+ * Queues the current block for the compressor. Blocks while the
+ * compressor is too far behind.
+ * @return Whether the stream is still good.
+ */
+bool CompressBuffer::handOff(){
+    if (file == nullptr) return false;
+
+    size_t size = (size_t) (pptr() - pbase());
+    if (size == 0) return !failed;
+    block.resize(size);
+
+    {
+        unique_lock<mutex> guard(lock);
+        changed.wait(guard, [this](){ return pending.size() < MAX_PENDING; });
+        pending.push_back(std::move(block));
+
+        //Reuse a block the compressor is done with.
+        block = vector<char>();
+        if (!spare.empty()){
+            block = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    changed.notify_all();
+
+    block.resize(BLOCK_SIZE);
+    setp(block.data(), block.data() + block.size());
+    return !failed;
+}
+
+/**
+ * Waits for the compressor to finish every queued block.
+ * @return Whether the stream is still good.
+ */
+bool CompressBuffer::drain(){
+    unique_lock<mutex> guard(lock);
+    changed.wait(guard, [this](){ return pending.empty() && !busy; });
+    return !failed;
+}
+
+/**
+ * Compressor thread. Encodes queued blocks in order until
+ * the stream is closed.
+ */
+void CompressBuffer::compressLoop(){
+    while (true){
+        vector<char> curr;
+        {
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [this](){ return done || !pending.empty(); });
+            if (pending.empty()) return;
+
+            curr = std::move(pending.front());
+            pending.pop_front();
+            busy = true;
+        }
+        changed.notify_all();
+
+        encode(curr.data(), curr.size(), false);
+        {
+            lock_guard<mutex> guard(lock);
+            spare.push_back(std::move(curr));
+            busy = false;
+        }
+        changed.notify_all();
+    }
+}
+
+/**
+ * Compresses data and writes the result to the file.
+ * @param data The data to compress.
+ * @param size The number of bytes.
+ * @param finish Whether this ends the stream.
+ */
+void CompressBuffer::encode(const char* data, size_t size, bool finish){
+    if (failed) return;
+
+    if (codec == TACodec::NONE){
+        writeOut(data, size);
+        return;
+    }
+
+    if (codec == TACodec::GZIP){
+        gzip.next_in = (Bytef*) data;
+        gzip.avail_in = (uInt) size;
+
+        int ret;
+        do {
+            gzip.next_out = (Bytef*) encoded.data();
+            gzip.avail_out = (uInt) encoded.size();
+            ret = deflate(&gzip, finish ? Z_FINISH : Z_NO_FLUSH);
+            if (ret == Z_STREAM_ERROR){
+                failed = true;
+                return;
+            }
+            writeOut(encoded.data(), encoded.size() - gzip.avail_out);
+        } while (gzip.avail_out == 0 || (finish && ret != Z_STREAM_END));
+        return;
+    }
+
+#ifdef BFX64_ZSTD
+    ZSTD_inBuffer in = {data, size, 0};
+    size_t remaining;
+    do {
+        ZSTD_outBuffer out = {encoded.data(), encoded.size(), 0};
+        remaining = ZSTD_compressStream2(zstd, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+        if (ZSTD_isError(remaining)){
+            failed = true;
+            return;
+        }
+        writeOut(encoded.data(), out.pos);
+    } while (finish ? remaining != 0 : in.pos < in.size);
+#endif
+}
+
+/**
+ * Writes bytes to the file.
+ * @param data The bytes.
+ * @param size The number of bytes.
+ */
+void CompressBuffer::writeOut(const char* data, size_t size){
+    if (size > 0 && fwrite(data, 1, size, file) != size) failed = true;
+}
+
+/**
+ * Opens a file for reading and detects its format.
+ * @param path The file to read.
+ */
+DecompressBuffer::DecompressBuffer(string path){
+    this->codec = TACodec::NONE;
+    this->rawPos = 0;
+    this->rawSize = 0;
+    this->outputFull = false;
+    this->atBoundary = true;
+    this->ended = false;
+    this->failed = false;
+    memset(&gzip, 0, sizeof(gzip));
+#ifdef BFX64_ZSTD
+    this->zstd = nullptr;
+#endif
+
+    file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return;
+
+    raw.resize(BLOCK_SIZE);
+    block.resize(BLOCK_SIZE);
+    setg(block.data(), block.data(), block.data());
+    fillRaw();
+
+    //Checks the magic number of the file.
+    const unsigned char* magic = (const unsigned char*) raw.data();
+    bool ready = true;
+    if (rawSize >= 2 && magic[0] == 0x1f && magic[1] == 0x8b){
+        codec = TACodec::GZIP;
+
+        //Window bits past 31 let zlib read either header.
+        ready = inflateInit2(&gzip, 15 + 32) == Z_OK;
+    } else if (rawSize >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd){
+        codec = TACodec::ZSTD;
+#ifdef BFX64_ZSTD
+        zstd = ZSTD_createDCtx();
+        ready = zstd != nullptr;
+#else
+        ready = false;
+#endif
+    }
+    if (!ready){
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+/**
+ * Destructor. Closes the file.
+ */
+DecompressBuffer::~DecompressBuffer(){
+    if (codec == TACodec::GZIP) inflateEnd(&gzip);
+#ifdef BFX64_ZSTD
+    ZSTD_freeDCtx(zstd);
+#endif
+    if (file != nullptr) fclose(file);
+}
+
+/**
+ * Checks whether the file was opened and can be decoded.
+ * @return Boolean indicating whether the file is open.
+ */
+bool DecompressBuffer::isOpen() const {
+    return file != nullptr;
+}
+
+/**
+ * Checks whether the compressed data was damaged or cut short.
+ * @return Boolean indicating whether the input is corrupt.
+ */
+bool DecompressBuffer::isCorrupt() const {
+    return failed;
+}
+
+/**
+ * Gets the detected format of the file.
+ * @return The codec of the file.
+ */
+TACodec::Codec DecompressBuffer::getCodec() const {
+    return codec;
+}
+
+/**
+ * Called when the block is used up. Decodes the next one.
+ * @return The next character, or EOF at the end.
+ */
+int DecompressBuffer::underflow(){
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+    if (file == nullptr) return traits_type::eof();
+
+    size_t size = decode();
+    if (size == 0) return traits_type::eof();
+
+    setg(block.data(), block.data(), block.data() + size);
+    return traits_type::to_int_type(*gptr());
+}
+
+/**
+ * Reads the next chunk of the file.
+ * @return Whether anything was read.
+ */
+bool DecompressBuffer::fillRaw(){
+    rawPos = 0;
+    rawSize = fread(raw.data(), 1, raw.size(), file);
+    return rawSize > 0;
+}
+
+/**
+ * Decodes the next block of output.
+ * @return The number of bytes decoded, zero at the end.
+ */
+size_t DecompressBuffer::decode(){
+    size_t produced = 0;
+    while (produced == 0 && !ended){
+        //Get more input unless the decoder still has output waiting.
+        if (rawPos == rawSize && !outputFull && !fillRaw()){
+            ended = true;
+            if (!atBoundary) failed = true;
+            break;
+        }
+
+        if (codec == TACodec::NONE){
+            produced = rawSize - rawPos;
+            memcpy(block.data(), raw.data() + rawPos, produced);
+            rawPos = rawSize;
+        } else if (codec == TACodec::GZIP){
+            gzip.next_in = (Bytef*) raw.data() + rawPos;
+            gzip.avail_in = (uInt) (rawSize - rawPos);
+            gzip.next_out = (Bytef*) block.data();
+            gzip.avail_out = (uInt) block.size();
+
+            size_t start = rawPos;
+            int ret = inflate(&gzip, Z_NO_FLUSH);
+            rawPos = rawSize - gzip.avail_in;
+            produced = block.size() - gzip.avail_out;
+            if (rawPos != start || produced > 0) atBoundary = false;
+
+            //Concatenated members carry on after the end of one.
+            if (ret == Z_STREAM_END){
+                inflateReset(&gzip);
+                atBoundary = true;
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR){
+                failed = true;
+                ended = true;
+            }
+        } else {
+#ifdef BFX64_ZSTD
+            ZSTD_inBuffer in = {raw.data(), rawSize, rawPos};
+            ZSTD_outBuffer out = {block.data(), block.size(), 0};
+            size_t ret = ZSTD_decompressStream(zstd, &out, &in);
+            if (ZSTD_isError(ret)){
+                failed = true;
+                ended = true;
+                break;
+            }
+            rawPos = in.pos;
+            produced = out.pos;
+            atBoundary = (ret == 0);
+#endif
+        }
+        outputFull = (produced == block.size());
+    }
+
+    return produced;
+}
+
+/**
+ * Opens a TA file for writing.
+ * @param path The file to write.
+ * @param codec The codec to compress with.
+ * @param level The compression level.
+ */
+TAOutStream::TAOutStream(string path, TACodec::Codec codec, int level) : ostream(nullptr),
+                                                                          buffer(path, codec, level){
+    rdbuf(&buffer);
+    if (!buffer.isOpen()) setstate(ios::badbit);
+}
+
+/**
+ * Checks whether the file was opened.
+ * @return Boolean indicating whether the file is open.
+ */
+bool TAOutStream::isOpen() const {
+    return buffer.isOpen();
+}
+
+/**
+ * Finishes and closes the file.
+ * @return Whether everything was written.
+ */
+bool TAOutStream::close(){
+    bool succ = buffer.close() && !fail();
+    if (!succ) setstate(ios::badbit);
+    return succ;
+}
+
+/**
+ * Opens a TA file for reading, decompressing it if needed.
+ * @param path The file to read.
+ */
+TAInStream::TAInStream(string path) : istream(nullptr), buffer(path){
+    rdbuf(&buffer);
+    if (!buffer.isOpen()) setstate(ios::badbit);
+}
+
+/**
+ * Checks whether the file was opened.
+ * @return Boolean indicating whether the file is open.
+ */
+bool TAInStream::isOpen() const {
+    return buffer.isOpen();
+}
+
+/**
+ * Checks whether the compressed data was damaged or cut short.
+ * @return Boolean indicating whether the input is corrupt.
+ */
+bool TAInStream::isCorrupt() const {
+    return buffer.isCorrupt();
+}
+
+/**
+ * Gets the detected format of the file.
+ * @return The codec of the file.
+ */
+TACodec::Codec TAInStream::getCodec() const {
+    return buffer.getCodec();
+}
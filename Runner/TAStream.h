@@ -0,0 +1,197 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TAStream.h
+//
+// Created By: Bryan J Muscedere
+// Date: 10/18/2026
+//
+// Optionally compressed TA file streams. Output is handed to a
+// background thread in large blocks that compresses it with gzip
+// or zstd and writes it out, so formatting never waits on the
+// compressor. Input detects the format from the first bytes of
+// the file and decompresses it on the fly.
+//
+// Copyright (C) 2017, Bryan J. Muscedere
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BFX64_TASTREAM_H
+#define BFX64_TASTREAM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#ifdef BFX64_ZSTD
+#include <zstd.h>
+#endif
+
+/**
+ * Compression formats for TA files.
+ */
+class TACodec {
+public:
+    enum Codec { NONE, GZIP, ZSTD };
+
+    /** Codec Helpers */
+    static bool parse(std::string spec, Codec& codec, int& level);
+    static bool isSupported(Codec codec);
+    static std::string getExtension(Codec codec);
+    static std::string getName(Codec codec);
+    static std::string addExtension(std::string path, Codec codec);
+
+    /** Default Levels */
+    static const int GZIP_DEFAULT_LEVEL = 6;
+    static const int ZSTD_DEFAULT_LEVEL = 3;
+};
+
+/**
+ * Stream buffer that writes a file through a compressor running
+ * on its own thread. Full blocks are queued for the thread, which
+ * only ever holds a couple of them, so memory stays bounded.
+ */
+class CompressBuffer : public std::streambuf {
+public:
+    /** Constructor / Destructor */
+    CompressBuffer(std::string path, TACodec::Codec codec, int level);
+    ~CompressBuffer();
+
+    CompressBuffer(const CompressBuffer&) = delete;
+    CompressBuffer& operator=(const CompressBuffer&) = delete;
+
+    /** Stream Operations */
+    bool isOpen() const;
+    bool close();
+
+protected:
+    int overflow(int c) override;
+    int sync() override;
+
+private:
+    /** Block Sizes */
+    static const size_t BLOCK_SIZE = 1024 * 1024;
+    static const size_t MAX_PENDING = 2;
+
+    /** Private Variables */
+    FILE* file;
+    TACodec::Codec codec;
+    z_stream gzip;
+#ifdef BFX64_ZSTD
+    ZSTD_CCtx* zstd;
+#endif
+    std::vector<char> block;
+    std::vector<char> encoded;
+
+    /** Compressor Thread State */
+    std::thread compressor;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<char>> pending;
+    std::vector<std::vector<char>> spare;
+    bool busy;
+    bool done;
+    std::atomic<bool> failed;
+
+    /** Helper Methods */
+    bool handOff();
+    bool drain();
+    void compressLoop();
+    void encode(const char* data, size_t size, bool finish);
+    void writeOut(const char* data, size_t size);
+};
+
+/**
+ * Stream buffer that reads a plain, gzip or zstd file. The
+ * format is detected from the first bytes of the file.
+ */
+class DecompressBuffer : public std::streambuf {
+public:
+    /** Constructor / Destructor */
+    DecompressBuffer(std::string path);
+    ~DecompressBuffer();
+
+    DecompressBuffer(const DecompressBuffer&) = delete;
+    DecompressBuffer& operator=(const DecompressBuffer&) = delete;
+
+    /** Getters */
+    bool isOpen() const;
+    bool isCorrupt() const;
+    TACodec::Codec getCodec() const;
+
+protected:
+    int underflow() override;
+
+private:
+    /** Block Size */
+    static const size_t BLOCK_SIZE = 1024 * 1024;
+
+    /** Private Variables */
+    FILE* file;
+    TACodec::Codec codec;
+    z_stream gzip;
+#ifdef BFX64_ZSTD
+    ZSTD_DCtx* zstd;
+#endif
+    std::vector<char> raw;
+    size_t rawPos;
+    size_t rawSize;
+    std::vector<char> block;
+    bool outputFull;
+    bool atBoundary;
+    bool ended;
+    bool failed;
+
+    /** Helper Methods */
+    bool fillRaw();
+    size_t decode();
+};
+
+/**
+ * Output stream for a TA file, compressed if asked.
+ */
+class TAOutStream : public std::ostream {
+public:
+    TAOutStream(std::string path, TACodec::Codec codec = TACodec::NONE, int level = 0);
+
+    bool isOpen() const;
+    bool close();
+
+private:
+    CompressBuffer buffer;
+};
+
+/**
+ * Input stream for a TA file, whether compressed or not.
+ */
+class TAInStream : public std::istream {
+public:
+    TAInStream(std::string path);
+
+    bool isOpen() const;
+    bool isCorrupt() const;
+    TACodec::Codec getCodec() const;
+
+private:
+    DecompressBuffer buffer;
+};
+
+#endif //BFX64_TASTREAM_H